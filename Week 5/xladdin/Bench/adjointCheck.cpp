@@ -0,0 +1,164 @@
+//	desc:	check of kFd1d::rollBwdAdjoint against finite differences
+//
+//	P = sum w(k,i) res(k,i) after numSteps bwd steps. the derivatives of P
+//	to r, mu and var at nodes across the grid and to the terminal results
+//	are compared with central bumps of repeated rollBwd prices, over general
+//	and uniform grids, theta 0, 1/2 and 1, all winds, several slots, log
+//	grids, checkpoint intervals and threaded solves. the max error over the
+//	checked nodes is relative to the largest bumped derivative
+//
+//	prints the errors per setup and returns 1 if any exceeds the tolerance
+//
+//	build:	cl /std:c++20 /O2 /EHsc /I..\Utility adjointCheck.cpp ..\Utility\*.cpp
+
+//	includes
+#include "kFd1d.h"
+#include <cstdio>
+
+//	tolerance on the relative errors
+static const double tol = 1.0e-6;
+
+//	setup
+struct Setup
+{
+	bool	uniform;
+	int		n, numV, numSteps;
+	double	theta;
+	int		wind, checkpoint;
+	bool	log, parallel;
+	bool	constant;	//	constant coefficients, compact operators on uniform grids
+};
+
+//	P by rollBwd
+template <class G>
+static double
+price(
+	kFd1d<double,G>&			fd,
+	const kVector<double>&		r,
+	const kVector<double>&		mu,
+	const kVector<double>&		var,
+	const kSlotMatrix<double>&	term,
+	const kSlotMatrix<double>&	w,
+	const Setup&				su)
+{
+	fd.r()	 = r;
+	fd.mu()	 = mu;
+	fd.var() = var;
+	kSlotMatrix<double> res = term;
+	for(int h=0;h<su.numSteps;++h) fd.rollBwd(1.0/su.numSteps, true, su.theta, su.wind, res);
+
+	double p = 0.0;
+	for(int k=0;k<res.numV();++k) for(int i=0;i<res.numX();++i) p += w(k,i) * res(k,i);
+	return p;
+}
+
+//	max relative errors to r, mu, var and the terminal results
+template <class G>
+static bool
+check(
+	const Setup&	su)
+{
+	//	helps
+	int i, k, q;
+	int n = su.n;
+
+	//	grid, stretched unless uniform
+	kVector<double> x(n);
+	for(i=0;i<n;++i) x(i) = 50.0 + 100.0 * (su.uniform ? (double)i/(n-1) : pow((double)i/(n-1), 1.3));
+	kFd1d<double,G> fd;
+	fd.init(su.numV, x, su.log);
+	if(su.parallel) fd.setParallel(true, nullptr, 4);
+
+	//	varying or constant coefficients, call payoffs, weights around the middle
+	kVector<double> r(n), mu(n), var(n);
+	kSlotMatrix<double> term(su.numV, n), w(su.numV, n);
+	for(i=0;i<n;++i)
+	{
+		r(i)   = su.constant ? 0.03 : 0.03 + 0.001*sin((double)i);
+		mu(i)  = su.constant ? 0.5 : (0.01 - 0.0003*i) * x(i) * (su.wind==2 ? 5.0 : 1.0);
+		var(i) = su.constant ? 400.0 : kInlines::sqr(0.2 * x(i) * (1.0 + 0.1*cos((double)i)));
+		for(k=0;k<su.numV;++k)
+		{
+			term(k,i) = max(0.0, x(i) - 100.0 - 3.0*k);
+			w(k,i)	  = i==n/2 ? 1.0 + k : i==n/2+1 ? 0.3 : 0.0;
+		}
+	}
+
+	//	adjoint
+	fd.r()	 = r;
+	fd.mu()	 = mu;
+	fd.var() = var;
+	kSlotMatrix<double> res = term, dres;
+	kVector<double> dr, dmu, dvar;
+	fd.rollBwdAdjoint(1.0/su.numSteps, su.numSteps, su.theta, su.wind, res, w, dr, dmu, dvar, dres, su.checkpoint);
+
+	//	bumps at about 10 nodes
+	double err[4] = { 0, 0, 0, 0 }, scale[4] = { 0, 0, 0, 0 };
+	for(i=1;i<n-1;i+=max(1, n/9))
+	{
+		for(q=0;q<3;++q)
+		{
+			kVector<double> rb = r, mub = mu, varb = var;
+			kVector<double>& b = q==0 ? rb : q==1 ? mub : varb;
+			double h = q==0 ? 1.0e-5 : q==1 ? 1.0e-4 * x(i) : 1.0e-4 * var(i);
+			b(i) += h;
+			double pu = price(fd, rb, mub, varb, term, w, su);
+			b(i) -= 2.0*h;
+			double pd = price(fd, rb, mub, varb, term, w, su);
+			double bump = (pu - pd) / (2.0*h);
+			double adj	= q==0 ? dr(i) : q==1 ? dmu(i) : dvar(i);
+			err[q]	 = max(err[q], fabs(bump - adj));
+			scale[q] = max(scale[q], fabs(bump));
+		}
+
+		k = su.numV - 1;
+		kSlotMatrix<double> tb = term;
+		double h = 1.0e-3;
+		tb(k,i) += h;
+		double pu = price(fd, r, mu, var, tb, w, su);
+		tb(k,i) -= 2.0*h;
+		double pd = price(fd, r, mu, var, tb, w, su);
+		double bump = (pu - pd) / (2.0*h);
+		err[3]	 = max(err[3], fabs(bump - dres(k,i)));
+		scale[3] = max(scale[3], fabs(bump));
+	}
+
+	//	report
+	bool ok = true;
+	for(q=0;q<4;++q)
+	{
+		err[q] /= max(scale[q], 1.0e-300);
+		ok = ok && err[q]<=tol;
+	}
+	printf("%s%s n %4d numV %d steps %3d theta %.1f wind %2d chk %3d log %d par %d | r %.1e mu %.1e var %.1e term %.1e  %s\n",
+		su.uniform ? "uniform" : "general", su.constant ? " const" : "      ", n, su.numV, su.numSteps, su.theta, su.wind, su.checkpoint, su.log, su.parallel,
+		err[0], err[1], err[2], err[3], ok ? "ok" : "FAILED");
+	return ok;
+}
+
+int
+main()
+{
+	//	uniform, n, numV, numSteps, theta, wind, checkpoint, log, parallel, constant
+	const Setup setups[] =
+	{
+		{ false, 101,  1,  50, 0.5,  0,   0, false, false, false },
+		{ false, 101,  2,  50, 1.0,  1,   3, false, false, false },
+		{ false, 101,  1, 200, 0.0, -1,   0, false, false, false },
+		{ false, 101,  1,  50, 0.5,  2,   1, false, false, false },
+		{ false, 101,  2,  50, 0.5,  0, 100, true,  false, false },
+		{ false, 101,  1,  50, 0.5,  0,   0, false, true,  false },
+		{ false, 1001, 1, 500, 0.5,  0,   0, false, false, false },
+		{ true,  101,  1,  50, 0.5,  0,   0, false, false, false },
+		{ true,  101,  2,  50, 0.5,  0,   0, false, false, true  }
+	};
+
+	bool ok = true;
+	for(const Setup& su : setups)
+	{
+		ok = (su.uniform ? check<kGridUniform>(su) : check<kGridGeneral>(su)) && ok;
+	}
+
+	//	done
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,121 @@
+//	desc:	check that the steady state of the fd loops makes no heap allocations
+//
+//	counts kVector / kMatrix heap allocations with kMemory::numAllocs() over
+//
+//		cached rollBwd		steps on a warm kFd1d, also across changes of dt,
+//							theta and coefficients that refactor the operators
+//		fdRunner			repeated runs on one workspace, equal and smaller grids
+//		kFdPortfolio		a portfolio priced once, and replicated 4, 16 and 64
+//							times: equal counts mean the trades past the first
+//							of each kind price without heap traffic
+//
+//	prints the counts and returns 1 if any steady state count is not 0
+//
+//	build:	cl /std:c++20 /O2 /EHsc /I..\Utility allocCheck.cpp ..\Utility\*.cpp
+
+//	includes
+#include "kBlack.h"
+#include "kFd1d.h"
+#include "kFdPortfolio.h"
+#include "kMemory.h"
+#include <cstdio>
+
+static int numFailed = 0;
+
+static void
+report(const char* what, long long allocs, long long expected)
+{
+	bool ok = allocs==expected;
+	if(!ok) ++numFailed;
+	printf("%-48s %6lld allocs   %s\n", what, allocs, ok ? "ok" : "FAILED");
+}
+
+int
+main()
+{
+	//	helps
+	int h, i;
+	long long n;
+
+	//	cached rollBwd
+	{
+		int nx = 201, numV = 4;
+		kVector<double> x(nx);
+		for(i=0;i<nx;++i) x(i) = 50.0 + 100.0 * i / (nx - 1);
+		kFd1d<double> fd;
+		fd.init(numV, x, false);
+		for(i=0;i<nx;++i)
+		{
+			fd.r()(i)	= 0.03;
+			fd.mu()(i)	= 0.01 * x(i);
+			fd.var()(i) = kInlines::sqr(0.2 * x(i));
+			for(int k=0;k<numV;++k) fd.res()(k,i) = max(0.0, x(i) - 90.0 - 5.0*k);
+		}
+		fd.rollBwd(0.01, true, 0.5, 0, fd.res());
+
+		n = kMemory::numAllocs();
+		for(h=0;h<200;++h) fd.rollBwd(0.01, true, 0.5, 0, fd.res());
+		report("rollBwd, cached operators", kMemory::numAllocs() - n, 0);
+
+		n = kMemory::numAllocs();
+		for(h=0;h<200;++h)
+		{
+			fd.r()(h % nx) += 1.0e-4;
+			fd.rollBwd(h%2 ? 0.01 : 0.005, true, h%3 ? 0.5 : 1.0, 0, fd.res());
+		}
+		report("rollBwd, refactored every step", kMemory::numAllocs() - n, 0);
+	}
+
+	//	fdRunner on a workspace, european and american by projection
+	{
+		kFd1d<double> fd;
+		kVector<double> s, res;
+		string err;
+		double res0;
+		kBlack::fdRunner(100.0, 0.01, 0.0, 0.2, 1.0, 100.0, false, 1, 0, 0, 0.5, 0, 5.0, 50, 200, true, 1, fd, res0, s, res, err);
+
+		const int numx[4] = { 200, 200, 150, 100 };
+		n = kMemory::numAllocs();
+		for(int rep=0;rep<4;++rep)
+		{
+			kBlack::fdRunner(100.0, 0.01, 0.0, 0.2, 1.0, 100.0, false, -1, rep%2, 0, 0.5, 0, 5.0, 50, numx[rep], true, 1, fd, res0, s, res, err);
+		}
+		report("fdRunner, reused workspace", kMemory::numAllocs() - n, 0);
+	}
+
+	//	portfolio: 16 distinct trades, replicated
+	{
+		const int B = 16;
+		long long base = -1;
+		for(int rep : { 1, 4, 16, 64 })
+		{
+			kVector<kFdTrade> trades(B * rep);
+			for(i=0;i<trades.size();++i)
+			{
+				int j = i % B;
+				kFdTrade& tr = trades(i);
+				tr.model  = j%3 ? 1 : 0;
+				tr.s0	  = 100.0;
+				tr.sigma  = tr.model ? 0.2 : 20.0;
+				tr.expiry = 1.0;
+				tr.strike = 80.0 + 3.0*j;
+				tr.ea	  = j%2;
+				tr.numx	  = 50 + 7*j;
+			}
+			kVector<double> res0;
+			string err;
+			n = kMemory::numAllocs();
+			if(!kFdPortfolio::price(trades, 1, res0, err)) printf("%s\n", err.c_str());
+			n = kMemory::numAllocs() - n;
+			if(base<0) base = n;
+
+			char what[64];
+			snprintf(what, sizeof(what), "kFdPortfolio, %d trades, over 16 trades", B * rep);
+			report(what, n - base, 0);
+		}
+		printf("%-48s %6lld allocs\n", "kFdPortfolio setup and first trades", base);
+	}
+
+	//	done
+	return numFailed ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+//	desc:	benchmark of the batched fd runners against the scalar ones
+//
+//	37 black and bachelier trades of mixed rate, drift, vol, expiry, strike,
+//	digital, put / call and european / american (projection), priced by
+//	fdRunnerBatch and trade by trade by fdRunner on the same grid. prints
+//	the wall times and the largest price difference, returns 1 if it is
+//	above 1e-10, rounding on prices of order 10
+//
+//	build:	cl /std:c++20 /O2 /EHsc /I..\Utility batchRunner.cpp ..\Utility\*.cpp
+
+//	includes
+#include "kBlack.h"
+#include "kBachelier.h"
+#include "kBench.h"
+#include <cmath>
+#include <cstdio>
+
+int
+main()
+{
+	//	helps
+	int i, model;
+
+	//	trades
+	const int numTr = 37;
+	kVector<double> s0(numTr), r(numTr), mu(numTr), sigma(numTr), expiry(numTr), strike(numTr);
+	kVector<int> dig(numTr), pc(numTr), ea(numTr);
+	for(i=0;i<numTr;++i)
+	{
+		s0(i)	  = 100.0;
+		r(i)	  = 0.01 * (i%3);
+		mu(i)	  = 0.005 * (i%4);
+		sigma(i)  = 0.1 + 0.01 * (i%7);
+		expiry(i) = i%9==0 ? 0.0 : 0.25 + 0.1 * (i%5);
+		strike(i) = 80.0 + i;
+		dig(i)	  = i%5==0;
+		pc(i)	  = i%2 ? 1 : -1;
+		ea(i)	  = i%3==0;
+	}
+
+	//	grid
+	const int	 smooth = 1, wind = 0, numt = 200, numx = 400;
+	const double theta	= 0.5, numStd = 5.0;
+
+	bool ok = true;
+	printf("%10s %12s %12s %8s %10s\n", "model", "batch ms", "scalar ms", "ratio", "max diff");
+	for(model=0;model<2;++model)
+	{
+		//	bachelier vols in price units
+		kVector<double> vol = sigma;
+		if(model) for(i=0;i<numTr;++i) vol(i) *= s0(i);
+
+		string error;
+		kVector<double> batch, scalar(numTr);
+		auto runBatch = [&]
+		{
+			if(model)	kBachelier::fdRunnerBatch(s0, r, mu, vol, expiry, strike, dig, pc, ea, smooth, theta, wind, numStd, numt, numx, batch, error);
+			else		kBlack::fdRunnerBatch(s0, r, mu, vol, expiry, strike, dig, pc, ea, smooth, theta, wind, numStd, numt, numx, batch, error);
+		};
+		auto runScalar = [&]
+		{
+			kVector<double> s, res;
+			for(i=0;i<numTr;++i)
+			{
+				if(model)	kBachelier::fdRunner(s0(i), r(i), mu(i), vol(i), expiry(i), strike(i), dig(i)>0, pc(i), ea(i), smooth, theta, wind, numStd, numt, numx, true, 1, scalar(i), s, res, error);
+				else		kBlack::fdRunner(s0(i), r(i), mu(i), vol(i), expiry(i), strike(i), dig(i)>0, pc(i), ea(i), smooth, theta, wind, numStd, numt, numx, true, 1, scalar(i), s, res, error);
+			}
+		};
+
+		double tb = kBench::time(runBatch);
+		double ts = kBench::time(runScalar);
+		double maxDiff = 0.0;
+		for(i=0;i<numTr;++i) maxDiff = max(maxDiff, fabs(batch(i) - scalar(i)));
+		if(maxDiff>1.0e-10) ok = false;
+
+		printf("%10s %12.2f %12.2f %8.2f %10.1e\n", model ? "bachelier" : "black", 1.0e3*tb, 1.0e3*ts, ts/tb, maxDiff);
+	}
+
+	//	done
+	return ok ? 0 : 1;
+}
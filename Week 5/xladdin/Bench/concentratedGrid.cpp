@@ -0,0 +1,74 @@
+//	desc:	accuracy of the strike concentrated grids of kFdGrid
+//
+//	s0 = 100, strike 103, r = 5%, mu = 3%, expiry 1, numt 2000 so the error is
+//	the one in s. prints the error at s0 against the closed form of fdRunner
+//	on the uniform grid (conc 0) and the concentrated one (conc 0.5) by numx
+//	for the black digital unsmoothed and smoothed, the black call unsmoothed
+//	and the bachelier digital unsmoothed
+//
+//	build:	cl /std:c++20 /O2 /EHsc /I..\Utility concentratedGrid.cpp ..\Utility\*.cpp
+
+//	includes
+#include "kBlack.h"
+#include "kBachelier.h"
+#include "kSpecialFunction.h"
+#include <cmath>
+#include <cstdio>
+
+int
+main()
+{
+	//	contract
+	const double s0 = 100.0, r = 0.05, mu = 0.03, expiry = 1.0, strike = 103.0, numStd = 5.0;
+	const double sigmaBk = 0.2, sigmaBa = 20.0, conc = 0.5;
+	const int	 numt = 2000;
+	const double df = exp(-r * expiry);
+
+	//	closed forms
+	double fBk	 = s0 * exp(mu * expiry);
+	double sdBk	 = sigmaBk * sqrt(expiry);
+	double digBk = df * kSpecialFunction::normalCdf(log(fBk / strike) / sdBk - 0.5 * sdBk);
+	double callBk = df * kBlack::call(expiry, strike, fBk, sigmaBk);
+	double fBa	 = s0 + mu * expiry;
+	double digBa = df * kSpecialFunction::normalCdf((fBa - strike) / (sigmaBa * sqrt(expiry)));
+
+	struct Case
+	{
+		const char*	name;
+		bool		black;
+		bool		dig;
+		int			smooth;
+		double		exact;
+	};
+	Case cases[] =
+	{
+		{ "black digital",			true,  true,  0, digBk	},
+		{ "black digital smoothed", true,  true,  1, digBk	},
+		{ "black call",				true,  false, 0, callBk },
+		{ "bachelier digital",		false, true,  0, digBa	}
+	};
+
+	//	errors at s0
+	for(const Case& c : cases)
+	{
+		printf("%s, exact %.10f\n%8s %12s %12s\n", c.name, c.exact, "numx", "uniform", "conc");
+		for(int numx : { 50, 100, 200, 400, 800, 1600 })
+		{
+			double err[2];
+			for(int k=0;k<2;++k)
+			{
+				double res0;
+				kVector<double> s, res;
+				string error;
+				if(c.black) kBlack::fdRunner(s0, r, mu, sigmaBk, expiry, strike, c.dig, 1, 0, c.smooth, 0.5, 0, numStd, numt, numx, true, 1, res0, s, res, error, k ? conc : 0.0);
+				else		kBachelier::fdRunner(s0, r, mu, sigmaBa, expiry, strike, c.dig, 1, 0, c.smooth, 0.5, 0, numStd, numt, numx, true, 1, res0, s, res, error, k ? conc : 0.0);
+				err[k] = fabs(res0 - c.exact);
+			}
+			printf("%8d %12.2e %12.2e\n", numx, err[0], err[1]);
+		}
+		printf("\n");
+	}
+
+	//	done
+	return 0;
+}
@@ -0,0 +1,67 @@
+//	desc:	convergence of kBlack::fdRunnerExtrap against plain crank-nicolson
+//
+//	atm call s0 = strike = 100, r = 5%, mu = 3%, sigma = 20%, expiry 1, 6 std,
+//	against the closed form. prints the errors of fdRunner (crank-nicolson)
+//	and fdRunnerExtrap (numRan 2) and the error estimate of the latter for
+//	numt = numx = N, then the smallest N at which each of them reaches 1e-6
+//	with its node steps and wall time. returns 1 if the estimate is off the
+//	error by more than a factor of 3 at N >= 100
+//
+//	build:	cl /std:c++20 /O2 /EHsc /I..\Utility extrapolation.cpp ..\Utility\*.cpp
+
+//	includes
+#include "kBlack.h"
+#include "kBench.h"
+#include <cmath>
+#include <cstdio>
+
+int
+main()
+{
+	//	contract
+	const double s0 = 100.0, r = 0.05, mu = 0.03, sigma = 0.2, expiry = 1.0, strike = 100.0, numStd = 6.0;
+	const double exact = exp(-r * expiry) * kBlack::call(expiry, strike, s0 * exp(mu * expiry), sigma);
+	printf("closed form %.12f\n\n", exact);
+
+	//	runs
+	string error;
+	kVector<double> s, res;
+	auto cn = [&](int N)
+	{
+		double res0;
+		kBlack::fdRunner(s0, r, mu, sigma, expiry, strike, false, 1, 0, 1, 0.5, 0, numStd, N, N, true, 1, res0, s, res, error);
+		return res0;
+	};
+	auto extrap = [&](int N, double& err)
+	{
+		double res0;
+		kBlack::fdRunnerExtrap(s0, r, mu, sigma, expiry, strike, false, 1, 0, 1, 0, numStd, N, N, 2, res0, err, error);
+		return res0;
+	};
+
+	//	errors and estimates
+	bool ok = true;
+	printf("%6s %12s %12s %12s\n", "N", "cn error", "extrap error", "estimate");
+	for(int N=25;N<=800;N*=2)
+	{
+		double err;
+		double v = extrap(N, err);
+		double e = fabs(v - exact);
+		if(N>=100 && (err>3.0*e || e>3.0*err)) ok = false;
+		printf("%6d %12.2e %12.2e %12.2e\n", N, fabs(cn(N) - exact), e, err);
+	}
+
+	//	smallest N for 1e-6
+	printf("\n%8s %6s %12s %12s %10s\n", "scheme", "N", "error", "node steps", "ms");
+	int N;
+	for(N=4000;fabs(cn(N) - exact)>=1.0e-6;N=(int)(1.05*N));
+	printf("%8s %6d %12.2e %12.3g %10.1f\n", "cn", N, fabs(cn(N) - exact), (double)N * (N+1),
+		1.0e3 * kBench::time([&] { cn(N); }, 0.0, 1));
+	double err;
+	for(N=40;fabs(extrap(N, err) - exact)>=1.0e-6;N+=4);
+	printf("%8s %6d %12.2e %12.3g %10.1f\n", "extrap", N, fabs(extrap(N, err) - exact), 9.25 * N * (N+1),
+		1.0e3 * kBench::time([&] { extrap(N, err); }));
+
+	//	done
+	return ok ? 0 : 1;
+}
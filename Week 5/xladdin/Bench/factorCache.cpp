@@ -0,0 +1,63 @@
+//	desc:	benchmark of the cached factorization of the implicit operator in kFd1d
+//
+//	crank-nicolson steps with constant coefficients, steps per second when
+//	kFd1d rebuilds and refactors the operators on every step (one coefficient
+//	changes by one ulp every step, as every step did before the
+//	cache) against the cached factorization with solve only sweeps, for
+//	numx = 100 ... 10000. the prices of the two must agree to rounding
+//
+//	build:	cl /std:c++20 /O2 /EHsc /I..\Utility factorCache.cpp ..\Utility\*.cpp
+
+//	includes
+#include "kFd1d.h"
+#include "kBench.h"
+#include <cmath>
+#include <cstdio>
+
+int
+main()
+{
+	//	helps
+	int h, i;
+
+	printf("%8s %14s %14s %8s %10s\n", "numx", "rebuilt / s", "cached / s", "ratio", "price diff");
+	for(int n : { 100, 300, 1000, 3000, 10000 })
+	{
+		//	grid and call payoff
+		kVector<double> x(n), payoff(n);
+		for(i=0;i<n;++i)
+		{
+			x(i)	  = -5.0 + 10.0 * i / (n - 1);
+			payoff(i) = max(x(i), 0.0);
+		}
+
+		//	numSteps crank-nicolson steps from the payoff, refactored or not
+		const int numSteps = 200;
+		kFd1d<double> fd;
+		fd.init(1, x, false);
+		double v[2];
+		auto run = [&](bool rebuild)
+		{
+			for(i=0;i<n;++i)
+			{
+				fd.r()(i)	= 0.01;
+				fd.mu()(i)	= 0.0;
+				fd.var()(i) = 1.0;
+			}
+			fd.res().setSlot(0, payoff);
+			for(h=0;h<numSteps;++h)
+			{
+				if(rebuild) fd.r()(0) = h%2 ? 0.01 : nextafter(0.01, 1.0);
+				fd.rollBwd(1.0 / numSteps, true, 0.5, 0, fd.res());
+			}
+			v[rebuild] = fd.res()(0, n/2);
+		};
+
+		double tr = kBench::time([&] { run(true); });
+		double tc = kBench::time([&] { run(false); });
+		printf("%8d %14.0f %14.0f %8.2f %10.1e\n", n, numSteps/tr, numSteps/tc, tr/tc, fabs(v[0] - v[1]));
+	}
+
+	//	done
+	return 0;
+}
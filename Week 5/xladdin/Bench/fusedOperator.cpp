@@ -0,0 +1,102 @@
+//	desc:	check and benchmark of the fused operator mode of kFd1d
+//
+//	first rolls bwd and fwd with changing coefficients for all winds, theta
+//	0, 0.5 and 1 and a few small grids with and without setFused(true), the
+//	results must be bit identical. then times rollBwd in ns per node per
+//	step for numx 1e3 to 1e6 and 1 or 4 slots: assembled with the
+//	coefficients changing every step, fused with the same, and assembled
+//	with constant coefficients and cached operators. returns 1 if the check
+//	fails
+//
+//	build:	cl /std:c++20 /O2 /EHsc /I..\Utility fusedOperator.cpp ..\Utility\*.cpp
+
+//	includes
+#include "kFd1d.h"
+#include "kBench.h"
+#include <cmath>
+#include <cstdio>
+
+//	time dependent coefficients at t
+static void
+setCoeffs(
+	kFd1d<double>&	fd,
+	double			t)
+{
+	for(int i=0;i<fd.x().size();++i)
+	{
+		double x	= fd.x()(i);
+		fd.r()(i)	= 0.01 + 0.001 * t;
+		fd.mu()(i)	= (0.02 - 0.05 * t) * x;
+		fd.var()(i) = (0.04 + 0.01 * t) * x * x;
+	}
+}
+
+int
+main()
+{
+	//	helps
+	int h, i, k;
+
+	//	bit identity
+	double maxDiff = 0.0;
+	for(int fwd=0;fwd<2;++fwd) for(int wind=-1;wind<=2;++wind) for(double theta : { 0.0, 0.5, 1.0 }) for(int n : { 1, 2, 3, 40 })
+	{
+		kVector<double> x(n);
+		for(i=0;i<n;++i) x(i) = 50.0 + 100.0 * i / max(1, n-1);
+
+		kFd1d<double> a, b;
+		a.init(3, x, false);
+		b.init(3, x, false);
+		b.setFused(true);
+		for(k=0;k<3;++k) for(i=0;i<n;++i) a.res()(k,i) = b.res()(k,i) = max(0.0, x(i) - 90.0 - 5.0 * k);
+
+		for(h=0;h<10;++h)
+		{
+			setCoeffs(a, 0.1 * h);
+			setCoeffs(b, 0.1 * h);
+			if(fwd)
+			{
+				a.rollFwd(0.1, true, theta, wind, a.res());
+				b.rollFwd(0.1, true, theta, wind, b.res());
+			}
+			else
+			{
+				a.rollBwd(0.1, true, theta, wind, a.res());
+				b.rollBwd(0.1, true, theta, wind, b.res());
+			}
+		}
+		for(k=0;k<3;++k) for(i=0;i<n;++i) maxDiff = max(maxDiff, fabs(a.res()(k,i) - b.res()(k,i)));
+	}
+	printf("max diff fused vs assembled %g\n\n", maxDiff);
+
+	//	timings
+	printf("%8s %5s %20s %20s %20s\n", "numx", "numV", "assembled changing", "fused changing", "assembled cached");
+	for(int n : { 1000, 100000, 1000000 }) for(int numV : { 1, 4 })
+	{
+		kVector<double> x(n);
+		for(i=0;i<n;++i) x(i) = 50.0 + 100.0 * i / (n - 1);
+
+		double ns[3];
+		for(int mode=0;mode<3;++mode)
+		{
+			kFd1d<double> fd;
+			fd.init(numV, x, false);
+			fd.setFused(mode==1);
+			setCoeffs(fd, 0.0);
+			const int numSteps = 10;
+			h = 0;
+			ns[mode] = kBench::time([&]
+			{
+				for(k=0;k<numSteps;++k,++h)
+				{
+					if(mode<2) for(i=0;i<n;++i) fd.r()(i) = 0.01 + 1.0e-6 * (h%1000);
+					fd.rollBwd(0.01, true, 0.5, 0, fd.res());
+				}
+			}) * 1.0e9 / numSteps / n;
+		}
+		printf("%8d %5d %20.2f %20.2f %20.2f\n", n, numV, ns[0], ns[1], ns[2]);
+	}
+
+	//	done
+	return maxDiff==0.0 ? 0 : 1;
+}
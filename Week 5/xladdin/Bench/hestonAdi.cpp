@@ -0,0 +1,132 @@
+//	desc:	accuracy and wall time of the adi schemes of kFd2d on the heston call
+//
+//	s0 = strike = 100, expiry 1, r = 3%, v0 = vbar = 0.04, kappa = 1.5, eta = 0.5,
+//	rho = -0.7 by kHeston::fdRunner. prints the error against the semi
+//	analytic price (gil-pelaez with the little trap characteristic function)
+//	of douglas, craig-sneyd, modified craig-sneyd and hundsdorfer-verwer on
+//	nt / ns / nv = N / 2N / N, the differences of hv as nt doubles on a fixed
+//	space grid, then the wall time of hv serial and on pools of 2 and 4
+//	threads for nt = nv / 2
+//
+//	build:	cl /std:c++20 /O2 /EHsc /I..\Utility hestonAdi.cpp ..\Utility\*.cpp
+
+//	includes
+#include "kHeston.h"
+#include "kThreadPool.h"
+#include "kBench.h"
+#include <cmath>
+#include <complex>
+#include <cstdio>
+
+//	semi analytic heston call
+static double
+hestonCall(
+	double	s0,
+	double	strike,
+	double	expiry,
+	double	r,
+	double	v0,
+	double	kappa,
+	double	vbar,
+	double	eta,
+	double	rho)
+{
+	using C = std::complex<double>;
+	const C i(0.0, 1.0);
+
+	//	characteristic function of log s at expiry
+	auto phi = [&](C u)
+	{
+		C b = kappa - rho * eta * i * u;
+		C d = sqrt(b * b + eta * eta * (i * u + u * u));
+		C g = (b - d) / (b + d);
+		C e = exp(-d * expiry);
+		C D = (b - d) / (eta * eta) * (1.0 - e) / (1.0 - g * e);
+		C A = kappa * vbar / (eta * eta) * ((b - d) * expiry - 2.0 * log((1.0 - g * e) / (1.0 - g)));
+		return exp(A + D * v0 + i * u * (log(s0) + r * expiry));
+	};
+
+	//	midpoint rule on (0, 400)
+	const int	 numU = 200000;
+	const double du	  = 400.0 / numU;
+	C phi1 = phi(-i);
+	double p1 = 0.0, p2 = 0.0;
+	for(int k=0;k<numU;++k)
+	{
+		double u = (k + 0.5) * du;
+		C	   w = exp(-i * u * log(strike)) / (i * u);
+		p1 += std::real(w * phi(u - i) / phi1) * du;
+		p2 += std::real(w * phi(C(u, 0.0))) * du;
+	}
+	const double pi = acos(-1.0);
+	p1 = 0.5 + p1 / pi;
+	p2 = 0.5 + p2 / pi;
+
+	//	done
+	return s0 * p1 - strike * exp(-r * expiry) * p2;
+}
+
+int
+main()
+{
+	//	contract and model
+	const double s0 = 100.0, strike = 100.0, expiry = 1.0, r = 0.03;
+	const double v0 = 0.04, kappa = 1.5, vbar = 0.04, eta = 0.5, rho = -0.7;
+	const double numStd = 5.0;
+	const double exact	= hestonCall(s0, strike, expiry, r, v0, kappa, vbar, eta, rho);
+	printf("semi analytic %.6f\n\n", exact);
+
+	//	scheme, theta
+	const char*	 name[]	 = { "douglas", "cs", "mcs", "hv" };
+	const double theta[] = { 0.5, 0.5, 1.0 / 3.0, 0.5 + sqrt(3.0) / 6.0 };
+	const int	 hv		 = 3;
+
+	string error;
+	double res0;
+	auto run = [&](int scheme, int nt, int ns, int nv, bool parallel = false, kThreadPool* pool = nullptr)
+	{
+		if(!kHeston::fdRunner(s0, v0, r, r, kappa, vbar, eta, rho, expiry, strike, false, 1, 1,
+			theta[scheme], 0, numStd, nt, ns, nv, scheme, res0, error, parallel, pool))
+		{
+			printf("%s\n", error.c_str());
+		}
+		return res0;
+	};
+
+	//	errors by scheme
+	printf("%12s %10s %10s %10s %10s\n", "nt/ns/nv", name[0], name[1], name[2], name[3]);
+	for(int n : { 25, 50, 100 })
+	{
+		printf("%4d/%3d/%3d", n, 2*n, n);
+		for(int scheme=0;scheme<4;++scheme) printf(" %10.1e", run(scheme, n, 2*n, n) - exact);
+		printf("\n");
+	}
+
+	//	time convergence of hv
+	printf("\nhv on ns / nv = 200 / 100\n%6s %12s %12s\n", "nt", "price", "difference");
+	double prev = 0.0;
+	for(int nt : { 25, 50, 100, 200, 400 })
+	{
+		double v = run(hv, nt, 200, 100);
+		if(nt==25)	printf("%6d %12.7f\n", nt, v);
+		else		printf("%6d %12.7f %12.1e\n", nt, v, v - prev);
+		prev = v;
+	}
+
+	//	wall time of hv
+	kThreadPool pool2(2), pool4(4);
+	printf("\nhv wall time, ms\n%10s %10s %10s %10s\n", "grid", "serial", "pool 2", "pool 4");
+	for(int n : { 50, 100, 200, 400 })
+	{
+		printf("%5dx%-4d", 2*n+1, n+1);
+		for(kThreadPool* pool : { (kThreadPool*)nullptr, &pool2, &pool4 })
+		{
+			double t = kBench::time([&] { run(hv, n/2, 2*n, n, pool!=nullptr, pool); }, 0.2, n<=100 ? 3 : 1);
+			printf(" %10.1f", 1.0e3*t);
+		}
+		printf("\n");
+	}
+
+	//	done
+	return 0;
+}
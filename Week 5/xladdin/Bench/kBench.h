@@ -0,0 +1,45 @@
+#pragma once
+
+//	desc:	timing for the bench drivers
+//
+//	time() calls f repeatedly until at least minTime seconds have passed and
+//	returns the seconds per call, the best of numRep such rounds to filter
+//	out noise from other processes
+
+//	includes
+#include <chrono>
+#include <functional>
+
+//	class declaration
+class kBench
+{
+public:
+
+	//	seconds per call of f
+	static double	time(
+		const std::function<void()>&	f,
+		double							minTime = 0.2,
+		int								numRep	= 3)
+	{
+		using clock = std::chrono::steady_clock;
+
+		double best = 1.0e300;
+		for(int rep=0;rep<numRep;++rep)
+		{
+			long long numCalls = 0;
+			clock::time_point t0 = clock::now();
+			double secs;
+			do
+			{
+				f();
+				++numCalls;
+				secs = std::chrono::duration<double>(clock::now() - t0).count();
+			}
+			while(secs<minTime);
+			if(secs/numCalls<best) best = secs/numCalls;
+		}
+
+		//	done
+		return best;
+	}
+};
@@ -0,0 +1,144 @@
+//	desc:	accuracy and throughput of the mixed precision kFd1dMixed
+//
+//	black call slots with strikes 80 to 120 on kBlack's grid, 200 cn steps
+//	after 2 implicit ones, rolled by kFd1d<double>, kFd1d<float>, kFd1dMixed
+//	and kFd1dMixed with refinement. prints the max error against double at
+//	s0 over the slots and over the grid relative to max(1, |v|) for n = 200
+//	to 20000 and 1 or 8 slots, then the ns per node, slot and step at
+//	n = 20000 for 1 to 128 slots
+//
+//	build:	cl /std:c++20 /O2 /EHsc /arch:AVX2 /I..\Utility mixedPrecision.cpp ..\Utility\*.cpp
+
+//	includes
+#include "kFd1dMixed.h"
+#include "kBlack.h"
+#include "kBench.h"
+#include <cmath>
+#include <cstdio>
+
+//	schemes
+enum { dbl, flt, mixed, refined, numSchemes };
+
+//	rolls numV call slots on numS nodes with every scheme, results node major
+static void
+run(
+	int					numS,
+	int					numV,
+	kVector<double>&	s,
+	kMatrix<double>		out[numSchemes],
+	double				ns[numSchemes])
+{
+	//	helps
+	int h, i, k, m;
+
+	const double sigma = 0.2, r = 0.03, expiry = 1.0;
+	const int	 numT  = 200;
+	kBlack::fdGrid(100.0, sigma, expiry, 5.0, numS, s);
+	int n = s.size();
+
+	//	payoff of slot k at node i
+	auto payoff = [&](int i, int k) { return max(s(i) - 100.0 * (0.8 + 0.4 * k / max(1, numV-1)), 0.0); };
+
+	//	coefficients
+	auto setup = [&](auto& fd, auto zero)
+	{
+		using X = decltype(zero);
+		kVector<X> x(n);
+		for(i=0;i<n;++i) x(i) = (X)s(i);
+		fd.init(numV, x, false);
+		for(i=0;i<n;++i)
+		{
+			fd.r()(i)	= (X)r;
+			fd.mu()(i)	= (X)(r * s(i));
+			fd.var()(i) = (X)(sigma * sigma * s(i) * s(i));
+		}
+	};
+
+	for(m=0;m<numSchemes;++m)
+	{
+		kFd1d<double> fdd;
+		kFd1d<float> fdf;
+		kFd1dMixed<> fdm;
+		if(m==dbl)		setup(fdd, 0.0);
+		else if(m==flt) setup(fdf, 0.0f);
+		else
+		{
+			setup(fdm, 0.0);
+			fdm.setRefine(m==refined);
+		}
+
+		//	payoff and roll, 2 implicit steps first
+		auto roll = [&]
+		{
+			for(i=0;i<n;++i) for(k=0;k<numV;++k)
+			{
+				double p = payoff(i, k);
+				if(m==dbl)		fdd.res()(k,i) = p;
+				else if(m==flt) fdf.res()(k,i) = (float)p;
+				else			fdm.res()(i,k) = (float)p;
+			}
+			double dt = expiry / numT;
+			for(h=0;h<numT;++h)
+			{
+				double theta  = h<2 ? 1.0 : 0.5;
+				bool   update = h<3;
+				if(m==dbl)		fdd.rollBwd(dt, update, theta, 0, fdd.res());
+				else if(m==flt) fdf.rollBwd((float)dt, update, (float)theta, 0, fdf.res());
+				else			fdm.rollBwd(dt, update, theta, 0);
+			}
+		};
+		ns[m] = 1.0e9 * kBench::time(roll, 0.1) / ((double)n * numV * numT);
+
+		out[m].resize(n, numV);
+		for(i=0;i<n;++i) for(k=0;k<numV;++k)
+		{
+			out[m](i,k) = m==dbl ? fdd.res()(k,i) : m==flt ? fdf.res()(k,i) : fdm.res()(i,k);
+		}
+	}
+}
+
+int
+main()
+{
+	//	helps
+	int i, k, m;
+
+	const char* name[] = { "double", "float", "mixed", "mixed + refine" };
+	kVector<double> s;
+	kMatrix<double> out[numSchemes];
+	double ns[numSchemes];
+
+	//	accuracy against double
+	printf("max error vs double, at s0 / over the grid relative\n%7s %5s", "n", "numV");
+	for(m=flt;m<numSchemes;++m) printf(" %20s", name[m]);
+	printf("\n");
+	for(int numS : { 200, 2000, 20000 }) for(int numV : { 1, 8 })
+	{
+		run(numS, numV, s, out, ns);
+		int n = s.size();
+		printf("%7d %5d", n, numV);
+		for(m=flt;m<numSchemes;++m)
+		{
+			double e0 = 0.0, e = 0.0;
+			for(k=0;k<numV;++k) e0 = max(e0, fabs(out[m](n/2,k) - out[dbl](n/2,k)));
+			for(i=0;i<n;++i) for(k=0;k<numV;++k) e = max(e, fabs(out[m](i,k) - out[dbl](i,k)) / max(1.0, fabs(out[dbl](i,k))));
+			printf("   %8.1e %8.1e", e0, e);
+		}
+		printf("\n");
+	}
+
+	//	throughput
+	printf("\nns per node, slot and step, n = 20001\n%5s", "numV");
+	for(m=0;m<numSchemes;++m) printf(" %15s", name[m]);
+	printf("\n");
+	for(int numV : { 1, 8, 32, 128 })
+	{
+		run(20000, numV, s, out, ns);
+		printf("%5d", numV);
+		for(m=0;m<numSchemes;++m) printf(" %15.2f", ns[m]);
+		printf("\n");
+	}
+
+	//	done
+	return 0;
+}
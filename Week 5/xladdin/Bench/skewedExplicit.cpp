@@ -0,0 +1,125 @@
+//	desc:	check and benchmark of the time skewed explicit steps of kFd1d
+//
+//	first checks rollBwdExplicit bitwise against repeated rollBwd at theta 0
+//	on stretched grids over tiles, blocks, slots, obstacle and a 4 thread
+//	pool. then prints ns per node, slot and step of both, single thread, for
+//	n = 1e3 to 1e6 on a general grid with varying coefficients, a uniform
+//	grid with constant ones, the general grid with an obstacle and the
+//	general grid with 4 slots. returns 1 if the check fails
+//
+//	build:	cl /std:c++20 /O2 /EHsc /I..\Utility skewedExplicit.cpp ..\Utility\*.cpp
+
+//	includes
+#include "kFd1d.h"
+#include "kThreadPool.h"
+#include "kBench.h"
+#include <cmath>
+#include <cstdio>
+
+//	ns per node, slot and step of numSteps naive and skewed explicit steps
+template <class G>
+static void
+timeSteps(
+	int			n,
+	int			numV,
+	int			numSteps,
+	bool		constant,
+	bool		obstacle,
+	double&		naive,
+	double&		skewed)
+{
+	//	helps
+	int h, i, k;
+
+	//	grid, coefficients, american put like payoff
+	kVector<double> x(n);
+	for(i=0;i<n;++i) x(i) = -5.0 + 10.0 * i / (n - 1);
+	kFd1d<double,G> a, b;
+	a.init(numV, x, true);
+	b.init(numV, x, true);
+	kSlotMatrix<double> obs(numV, n);
+	for(kFd1d<double,G>* fd : { &a, &b })
+	{
+		for(i=0;i<n;++i)
+		{
+			fd->r()(i)	 = 0.03;
+			fd->mu()(i)	 = constant ? 0.01 : 0.01 - 0.002 * x(i);
+			fd->var()(i) = constant ? 0.04 : 0.04 + 0.001 * x(i) * x(i);
+		}
+		for(k=0;k<numV;++k) for(i=0;i<n;++i) fd->res()(k,i) = obs(k,i) = max(0.0, 1.0 - exp(x(i)) - 0.01 * k);
+	}
+
+	//	stable step
+	double dx = 10.0 / (n - 1);
+	double dt = 0.4 * dx * dx / 0.07;
+
+	double norm = 1.0e9 / ((double)numSteps * n * numV);
+	naive  = norm * kBench::time([&]
+	{
+		for(h=0;h<numSteps;++h) a.rollBwd(dt, true, 0.0, 0, a.res(), obstacle ? &obs : nullptr);
+	}, 0.0);
+	skewed = norm * kBench::time([&]
+	{
+		b.rollBwdExplicit(dt, numSteps, 0, b.res(), obstacle ? &obs : nullptr);
+	}, 0.0);
+}
+
+int
+main()
+{
+	//	helps
+	int h, i, k;
+
+	//	bitwise check
+	kThreadPool pool(4);
+	double maxDiff = 0.0;
+	for(int n : { 5, 7, 33, 200 }) for(int numV : { 1, 3 }) for(int tile : { 1, 3, 16, 0 }) for(int block : { 1, 2, 5, 0 })
+		for(int parallel=0;parallel<2;++parallel) for(int obstacle=0;obstacle<2;++obstacle)
+	{
+		kVector<double> x(n);
+		for(i=0;i<n;++i) x(i) = -2.0 + 4.0 * i * i / ((n - 1) * (n - 1));
+
+		kFd1d<double> a, b;
+		a.init(numV, x, false);
+		b.init(numV, x, false);
+		kSlotMatrix<double> obs(numV, n);
+		for(kFd1d<double>* fd : { &a, &b })
+		{
+			for(i=0;i<n;++i)
+			{
+				fd->r()(i)	 = 0.03;
+				fd->mu()(i)	 = 0.1 * x(i);
+				fd->var()(i) = 0.04;
+			}
+			for(k=0;k<numV;++k) for(i=0;i<n;++i)
+			{
+				obs(k,i)	   = max(0.0, 1.0 - x(i) - 0.01 * k);
+				fd->res()(k,i) = obs(k,i) + 0.1 * sin(3.0 * i);
+			}
+		}
+
+		const int numSteps = 13;
+		for(h=0;h<numSteps;++h) a.rollBwd(1.0e-4, true, 0.0, 2, a.res(), obstacle ? &obs : nullptr);
+		b.rollBwdExplicit(1.0e-4, numSteps, 2, b.res(), obstacle ? &obs : nullptr, tile, block, parallel>0, &pool);
+		for(k=0;k<numV;++k) for(i=0;i<n;++i) maxDiff = max(maxDiff, fabs(a.res()(k,i) - b.res()(k,i)));
+	}
+	printf("max diff skewed vs naive %g\n\n", maxDiff);
+
+	//	timings
+	printf("%8s %20s %20s %20s %20s\n", "n", "general", "uniform constant", "obstacle", "general 4 slots");
+	for(int n : { 1000, 10000, 100000, 1000000 })
+	{
+		int numSteps = min(4000, max(64, 50000000 / n));
+		double na[4], sk[4];
+		timeSteps<kGridGeneral>(n, 1, numSteps, false, false, na[0], sk[0]);
+		timeSteps<kGridUniform>(n, 1, numSteps, true, false, na[1], sk[1]);
+		timeSteps<kGridGeneral>(n, 1, numSteps, false, true, na[2], sk[2]);
+		timeSteps<kGridGeneral>(n, 4, numSteps/4, false, false, na[3], sk[3]);
+		printf("%8d", n);
+		for(k=0;k<4;++k) printf(" %8.2f -> %8.2f", na[k], sk[k]);
+		printf("\n");
+	}
+
+	//	done
+	return maxDiff==0.0 ? 0 : 1;
+}
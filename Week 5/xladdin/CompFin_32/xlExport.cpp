@@ -325,13 +325,15 @@ xFd1d(
 	for(int i=0;i<fd_var.size();++i)
 		fd_var(i) *= fd_var(i);
 
-	fd.res().resize(1);
-	if(!kXlUtils::getVector(v0_in, fd.res()[0]))
+	kVector<double> v0;
+	if(!kXlUtils::getVector(v0_in, v0))
 		return kXlUtils::setError("input 2 is not a vector");
 
-	if(n!=fd.res()[0].size())
+	if(n!=v0.size())
 		return kXlUtils::setError("v0 must have same size as x");
 
+	fd.res().setSlot(0, v0);
+
 	if(theta<0.0) theta=0.0;
 	if(theta>1.0) theta=1.0;
 
@@ -349,7 +351,8 @@ xFd1d(
 	}
 
 	LPXLOPER12 out = TempXLOPER12();
-	kXlUtils::setVector(fd.res()[0], out);
+	fd.res().getSlot(0, v0);
+	kXlUtils::setVector(v0, out);
 	return out;
 }
 
@@ -412,23 +415,29 @@ xBachelierFd(
 	
 	//	run
 	double res0;
-	kVector<double> s, res;
-	if (!kBachelier::fdRunner(s0, r, mu, sigma, expiry, strike, dig>0, pc, ea, smooth, theta, wind, numStd, numT, numX, update>0, numPr, res0, s, res, err)) return kXlUtils::setError(err);
+	kVector<double> s, res, greeks0;
+	kMatrix<double> greeks;
+	if (!kBachelier::fdRunner(s0, r, mu, sigma, expiry, strike, dig>0, pc, ea, smooth, theta, wind, numStd, numT, numX, update>0, numPr, res0, s, res, err, 0.0, &greeks0, &greeks)) return kXlUtils::setError(err);
 
 	//	size output
 	numRows = 3 + s.size();
-	numCols = 2;
+	numCols = 5;
 	LPXLOPER12 out = kXlUtils::getOper(numRows, numCols);
 
-	//	fill output
+	//	fill output, greeks at s0 next to res 0
 	kXlUtils::setStr(0, 0, "res 0", out);
 	kXlUtils::setDbl(0, 1, res0, out);
+	for(i=0;i<3;++i) kXlUtils::setDbl(0, 2+i, greeks0(i), out);
 	kXlUtils::setStr(2, 0, "s", out);
 	kXlUtils::setStr(2, 1, "res", out);
+	kXlUtils::setStr(2, 2, "delta", out);
+	kXlUtils::setStr(2, 3, "gamma", out);
+	kXlUtils::setStr(2, 4, "theta", out);
 	for(k=3, i=0; i<s.size(); ++i, ++k)
 	{
 		kXlUtils::setDbl(k, 0, s(i), out);
 		kXlUtils::setDbl(k, 1, res(i), out);
+		for(int j=0;j<3;++j) kXlUtils::setDbl(k, 2+j, greeks(i,j), out);
 	}
 
 	//	done
@@ -494,23 +503,29 @@ xBlackFd(
 
 	//	run
 	double res0;
-	kVector<double> s, res;
-	if (!kBlack::fdRunner(s0, r, mu, sigma, expiry, strike, dig > 0, pc, ea, smooth, theta, wind, numStd, numT, numX, update > 0, numPr, res0, s, res, err)) return kXlUtils::setError(err);
+	kVector<double> s, res, greeks0;
+	kMatrix<double> greeks;
+	if (!kBlack::fdRunner(s0, r, mu, sigma, expiry, strike, dig > 0, pc, ea, smooth, theta, wind, numStd, numT, numX, update > 0, numPr, res0, s, res, err, 0.0, &greeks0, &greeks)) return kXlUtils::setError(err);
 
 	//	size output
 	numRows = 3 + s.size();
-	numCols = 2;
+	numCols = 5;
 	LPXLOPER12 out = kXlUtils::getOper(numRows, numCols);
 
-	//	fill output
+	//	fill output, greeks at s0 next to res 0
 	kXlUtils::setStr(0, 0, "res 0", out);
 	kXlUtils::setDbl(0, 1, res0, out);
+	for(i=0;i<3;++i) kXlUtils::setDbl(0, 2+i, greeks0(i), out);
 	kXlUtils::setStr(2, 0, "s", out);
 	kXlUtils::setStr(2, 1, "res", out);
+	kXlUtils::setStr(2, 2, "delta", out);
+	kXlUtils::setStr(2, 3, "gamma", out);
+	kXlUtils::setStr(2, 4, "theta", out);
 	for (k = 3, i = 0; i < s.size(); ++i, ++k)
 	{
 		kXlUtils::setDbl(k, 0, s(i), out);
 		kXlUtils::setDbl(k, 1, res(i), out);
+		for(int j=0;j<3;++j) kXlUtils::setDbl(k, 2+j, greeks(i,j), out);
 	}
 
 	//	done
@@ -581,13 +596,15 @@ xAde(
 	for (int i = 0; i < fd_var.size(); ++i)
 		fd_var(i) *= fd_var(i);
 
-	ade.myRes.resize(1);
-	if (!kXlUtils::getVector(v0_in, ade.myRes[0]))
+	kVector<double> v0;
+	if (!kXlUtils::getVector(v0_in, v0))
 		return kXlUtils::setError("input 2 is not a vector");
 
-	if (n != ade.myRes[0].size())
+	if (n != v0.size())
 		return kXlUtils::setError("v0 must have same size as x");
 
+	ade.myRes.setSlot(0, v0);
+
 	double dt = t / numt;
 	for (int n = 0; n < numt; ++n)
 	{
@@ -602,7 +619,8 @@ xAde(
 	}
 
 	LPXLOPER12 out = TempXLOPER12();
-	kXlUtils::setVector(ade.myRes[0], out);
+	ade.myRes.getSlot(0, v0);
+	kXlUtils::setVector(v0, out);
 	return out;
 }
 
@@ -20,10 +20,23 @@
 //	
 //		d^2/dx^2 ~ (dxu - dxd)/dx
 //	
+//	the two sweeps are independent. serial runs them one after the other,
+//	interleaved runs both recurrences in one pass over the nodes (the down
+//	sweep from the bottom, the up sweep from the top) so the two dependency
+//	chains overlap, with the banded products and the final average fused in.
+//	concurrent runs them on two threads of a pool, do not use it from tasks
+//	of the same pool. all modes give the same results
+//
+//	the operators are kept between rolls and only rebuilt when dt, wind,
+//	the direction or the coefficients change, so steady steps are the
+//	banded products and the bidiagonal solves, without allocation
+//
 
 //	includes
 #include "kFiniteDifference.h"
 #include "kMatrixAlgebra.h"
+#include "kSlotMatrix.h"
+#include "kThreadPool.h"
 
 //	class declaration
 template <class V>
@@ -31,11 +44,28 @@ class kAde
 {
 public:
 
+	//	sweep modes
+	enum Sweeps
+	{
+		serial,
+		interleaved,
+		concurrent
+	};
+
 	//	init
 	void	init(
 		int					numV,
 		const kVector<V>&	x);
 
+	//	sweep mode, null pool for the shared one
+	void	setSweeps(
+		Sweeps				sweeps,
+		kThreadPool*		pool = nullptr)
+	{
+		mySweeps = sweeps;
+		myPool	 = pool;
+	}
+
 	//	1st order operators
 	static void		dx(
 		const kVector<V>&	x,
@@ -78,33 +108,84 @@ public:
 		kMatrix<V>&			B);
 	
 	//	roll bwd
+	void	rollBwd(
+		const V&				dt,
+		int						wind,
+		kSlotMatrix<V>&			res);
+
+	//	roll bwd, vector of vectors results
 	void	rollBwd(
 		const V&				dt,
 		int						wind,
 		kVector<kVector<V> >&	res);
 
 	//	roll fwd
+	void	rollFwd(
+		const V&				dt,
+		int						wind,
+		kSlotMatrix<V>&			res);
+
+	//	roll fwd, vector of vectors results
 	void	rollFwd(
 		const V&				dt,
 		int						wind,
 		kVector<kVector<V> >&	res);
 
+	//	operator state changed since last build
+	bool	isDirty(
+		const V&				dt,
+		int						wind,
+		bool					tr);
+
 	//	x, r, mu, var
 	kVector<V>				myX, myR, myMu, myVar;
 
 	//	res
-	kVector<kVector<V> >	myRes;
+	kSlotMatrix<V>			myRes;
 
 	//	helpers
 	kMatrix<V>				mydxd, mydxu, myDxd, myDxu, myDxxd, myDxxu;
 
-	//	operators
-	kMatrix<V>				myAd, myAu, myBd, myBu;
+	//	operators, explicit B = 1 + dt A and implicit C = 1 - dt A
+	kMatrix<V>				myAd, myAu, myBd, myBu, myCd, myCu;
 
-	//	helpers
-	kVector<V>				myVe;
-	kVector<kVector<V> >	myResd, myResu;
+	//	helpers, n x numV with slot index inner
+	kMatrix<V>				myVe, myVu, myResd, myResu;
+	kSlotMatrix<V>			myTmp;
+
+	//	sweeps
+	Sweeps					mySweeps{serial};
+	kThreadPool*			myPool{nullptr};
+
+private:
 
+	//	build operators, transposed for fwd rolls
+	void	buildOp(
+		const V&				dt,
+		int						wind,
+		bool					tr);
+
+	//	operator cache: r, mu, var, dt, wind and direction the operators were built for
+	kVector<V>				myRc, myMuc, myVarc;
+	V						myDtc{0.0};
+	int						myWindc{0};
+	bool					myTrc{false};
+
+	//	pivots 1 / Cd(i,1) and 1 / Cu(i,0)
+	kVector<V>				myPd, myPu;
+
+	//	pool
+	kThreadPool&	pool() const { return myPool ? *myPool : kThreadPool::global(); }
+
+	//	mode of this roll, concurrent needs two threads
+	Sweeps			sweeps() const { return mySweeps==concurrent && pool().numThreads()<2 ? interleaved : mySweeps; }
+
+	//	interleaved sweeps, result into F
+	void	interleavedBwd(
+		kMatrixView<V>			F);
+
+	void	interleavedFwd(
+		kMatrixView<V>			F);
 };
 
 //	init
@@ -124,7 +205,7 @@ kAde<V>::init(
 	myR.resize(m, 0.0);
 	myMu.resize(m, 0.0);
 	myVar.resize(m, 0.0);
-	myRes.resize(numV, kVector<V>(m,0.0));
+	myRes.resize(numV, m);
 
 	//	construct operators
 	kFiniteDifference::dxd(myX, mydxd);
@@ -135,9 +216,15 @@ kAde<V>::init(
 	dxx(myX, mydxd, mydxu, myDxxd, myDxxu);
 
 	//	helpers
-	myVe.resize(m);
-	myResd.resize(numV);
-	myResu.resize(numV);
+	myVe.resize(m, numV);
+	myVu.resize(m, numV);
+	myResd.resize(m, numV);
+	myResu.resize(m, numV);
+
+	//	operators are built on the first roll
+	myRc.clear();
+	myMuc.clear();
+	myVarc.clear();
 
 	//	done
 	return;
@@ -353,111 +440,333 @@ kAde<V>::calcB(
 	return;
 }
 
+//	operator state changed since last build
+template <class V>
+bool
+kAde<V>::isDirty(
+	const V&				dt,
+	int						wind,
+	bool					tr)
+{
+	//	dims
+	int n = myX.size();
+
+	//	step, scheme and direction
+	bool dirty = dt!=myDtc || wind!=myWindc || tr!=myTrc || myRc.size()!=n;
+
+	//	coefficients
+	for(int i=0;!dirty && i<n;++i)
+	{
+		dirty = myR(i)!=myRc(i) || myMu(i)!=myMuc(i) || myVar(i)!=myVarc(i);
+	}
+
+	//	record new state
+	if(dirty)
+	{
+		myRc	= myR;
+		myMuc	= myMu;
+		myVarc	= myVar;
+		myDtc	= dt;
+		myWindc	= wind;
+		myTrc	= tr;
+	}
+
+	//	done
+	return dirty;
+}
+
+//	build operators
+template <class V>
+void
+kAde<V>::buildOp(
+	const V&				dt,
+	int						wind,
+	bool					tr)
+{
+	//	calc A, transposed for fwd
+	if(tr)
+	{
+		calcA(wind, myCd, myCu);
+		kMatrixAlgebra::transpose(myCd, 1, 0, myAu);
+		kMatrixAlgebra::transpose(myCu, 0, 1, myAd);
+	}
+	else
+	{
+		calcA(wind, myAd, myAu);
+	}
+
+	//	explicit and implicit operators
+	calcB(1.0, dt, 0, myAu, myBu);
+	calcB(1.0, dt, 1, myAd, myBd);
+	calcB(1.0,-dt, 0, myAu, myCu);
+	calcB(1.0,-dt, 1, myAd, myCd);
+
+	//	pivots
+	int n = myX.size();
+	myPd.resize(n);
+	myPu.resize(n);
+	for(int i=0;i<n;++i)
+	{
+		myPd(i) = 1.0/myCd(i,1);
+		myPu(i) = 1.0/myCu(i,0);
+	}
+
+	//	done
+	return;
+}
+
 //	roll bwd
 template <class V>
 void	
 kAde<V>::rollBwd(
 	const V&				dt,
 	int						wind,
-	kVector<kVector<V> >&	res)
+	kSlotMatrix<V>&			res)
 {
 	//	tjek
 	if (!myX.size()) return;
 
-	//	dim
-	int numV = res.size();
+	//	slot major results are rolled in node major work storage
+	if(res.layout()!=kSlotMatrix<V>::nodeMajor)
+	{
+		myTmp.resize(res.numV(), res.numX());
+		res.copyTo(myTmp);
+		rollBwd(dt, wind, myTmp);
+		myTmp.copyTo(res);
+		return;
+	}
 
 	//	helps
-	int h, i;
+	int i;
 
-	//	calc A
-	calcA(wind, myAd, myAu);
+	//	slots
+	kMatrixView<V> F = res();
+	myVe.resize(F.rows(), F.cols());
+	myVu.resize(F.rows(), F.cols());
+	myResd.resize(F.rows(), F.cols());
+	myResu.resize(F.rows(), F.cols());
 
-	//	explicit (u) and implicit (d) roll back
-	calcB(1.0, dt, 0, myAu, myBu);
-	calcB(1.0,-dt, 1, myAd, myBd);
-	for(h=0;h<numV;++h)
+	//	operators, only rebuilt if something changed
+	if(isDirty(dt, wind, false)) buildOp(dt, wind, false);
+
+	//	interleaved, averages in place
+	Sweeps mode = sweeps();
+	if(mode==interleaved)
 	{
-		kMatrixAlgebra::banmul(myBu, 0, 1, res(h), myVe);
-		kMatrixAlgebra::leftdag(myBd, myVe, myResd(h));
+		interleavedBwd(F);
+		return;
 	}
 
-	//	explicit (d) and implicit (u) roll back
-	calcB(1.0, dt, 1, myAd, myBd);
-	calcB(1.0,-dt, 0, myAu, myBu);
-	for(h=0;h<numV;++h)
+	//	explicit (u) and implicit (d), explicit (d) and implicit (u) roll back
+	auto sweep = [&](int k, int)
 	{
-		kMatrixAlgebra::banmul(myBd, 1, 0, res(h), myVe);
-		kMatrixAlgebra::rightdag(myBu, myVe, myResu(h));
+		if(k==0)
+		{
+			kMatrixAlgebra::banmulMulti(myBu(), 0, 1, F, myVe());
+			kMatrixAlgebra::leftdagMulti(myCd(), myVe(), myResd());
+		}
+		else
+		{
+			kMatrixAlgebra::banmulMulti(myBd(), 1, 0, F, myVu());
+			kMatrixAlgebra::rightdagMulti(myCu(), myVu(), myResu());
+		}
+	};
+	if(mode==concurrent)
+	{
+		pool().parallelFor(2, sweep);
+	}
+	else
+	{
+		sweep(0, 0);
+		sweep(1, 0);
 	}
 
 	//	set result
-	for(h=0;h<numV;++h)
+	for(i=0;i<F.size();++i)
 	{
-		const kVector<V>& resd = myResd(h);
-		const kVector<V>& resu = myResu(h);
-		kVector<V>& resh = res(h);
-		for (i = 0; i < myX.size(); ++i)
-		{
-			resh(i) = 0.5*(resd(i) + resu(i));
-		}
+		F[i] = 0.5*(myResd[i] + myResu[i]);
 	}
 
 	//	done
 	return;
 }
 
+//	roll bwd, vector of vectors results
+template <class V>
+void	
+kAde<V>::rollBwd(
+	const V&				dt,
+	int						wind,
+	kVector<kVector<V> >&	res)
+{
+	myTmp.setSlots(res);
+	rollBwd(dt, wind, myTmp);
+	myTmp.getSlots(res);
+
+	//	done
+	return;
+}
+
 //	roll fwd
 template <class V>
 void	
 kAde<V>::rollFwd(
 	const V&				dt,
 	int						wind,
-	kVector<kVector<V> >&	res)
+	kSlotMatrix<V>&			res)
 {
 	//	tjek
 	if(!myX.size()) return;
 
-	//	dims
-	int numV = res.size();
+	//	slot major results are rolled in node major work storage
+	if(res.layout()!=kSlotMatrix<V>::nodeMajor)
+	{
+		myTmp.resize(res.numV(), res.numX());
+		res.copyTo(myTmp);
+		rollFwd(dt, wind, myTmp);
+		myTmp.copyTo(res);
+		return;
+	}
 
 	//	helps
-	int h, i;
+	int i;
 
-	//	calc A
-	calcA(wind, myBd, myBu);
-	kMatrixAlgebra::transpose(myBd, 1, 0, myAu);
-	kMatrixAlgebra::transpose(myBu, 0, 1, myAd);
+	//	slots
+	kMatrixView<V> F = res();
+	myVe.resize(F.rows(), F.cols());
+	myVu.resize(F.rows(), F.cols());
+	myResd.resize(F.rows(), F.cols());
+	myResu.resize(F.rows(), F.cols());
 
-	//	implicit (u) and explicit (d) roll
-	calcB(1.0,-dt, 0, myAu, myBu);
-	calcB(1.0, dt, 1, myAd, myBd);
-	for(h=0;h<numV;++h)
+	//	operators, only rebuilt if something changed
+	if(isDirty(dt, wind, true)) buildOp(dt, wind, true);
+
+	//	interleaved, averages in place
+	Sweeps mode = sweeps();
+	if(mode==interleaved)
 	{
-		myResd(h) = res(h);
-		kMatrixAlgebra::rightdag(myBu, myResd(h), myVe);
-		kMatrixAlgebra::banmul(myBd, 1, 0, myVe, myResd(h));
+		interleavedFwd(F);
+		return;
 	}
 
-	//	implicit (d) and explicit (d) roll
-	calcB(1.0,-dt, 1, myAd, myBd);
-	calcB(1.0, dt, 0, myAu, myBu);
-	for(h=0;h<numV;++h)
+	//	implicit (u) and explicit (d), implicit (d) and explicit (u) roll
+	auto sweep = [&](int k, int)
+	{
+		if(k==0)
+		{
+			kMatrixAlgebra::rightdagMulti(myCu(), F, myVu());
+			kMatrixAlgebra::banmulMulti(myBd(), 1, 0, myVu(), myResd());
+		}
+		else
+		{
+			kMatrixAlgebra::leftdagMulti(myCd(), F, myVe());
+			kMatrixAlgebra::banmulMulti(myBu(), 0, 1, myVe(), myResu());
+		}
+	};
+	if(mode==concurrent)
 	{
-		myResu(h) = res(h);
-		kMatrixAlgebra::leftdag(myBd, myResu(h), myVe);
-		kMatrixAlgebra::banmul(myBu, 0, 1, myVe, myResu(h));
+		pool().parallelFor(2, sweep);
+	}
+	else
+	{
+		sweep(0, 0);
+		sweep(1, 0);
 	}
 
 	//	set result
-	for(h=0;h<numV;++h)
+	for(i=0;i<F.size();++i)
+	{
+		F[i] = 0.5*(myResd[i] + myResu[i]);
+	}
+
+	//	done
+	return;
+}
+
+//	roll fwd, vector of vectors results
+template <class V>
+void	
+kAde<V>::rollFwd(
+	const V&				dt,
+	int						wind,
+	kVector<kVector<V> >&	res)
+{
+	myTmp.setSlots(res);
+	rollFwd(dt, wind, myTmp);
+	myTmp.getSlots(res);
+
+	//	done
+	return;
+}
+
+//	interleaved sweeps bwd
+template <class V>
+void
+kAde<V>::interleavedBwd(
+	kMatrixView<V>			F)
+{
+	//	dims
+	int n = F.rows() - 1;
+	int numV = F.cols();
+
+	//	helps
+	int k, i, j, h;
+	V a0, a1, c, b;
+
+	//	step k takes the down sweep to node k and the up sweep to node n-k.
+	//	a node is averaged into F by the second sweep to reach it, neither
+	//	sweep reads F there afterwards
+	for(k=0;k<=n;++k)
 	{
-		const kVector<V>& resd = myResd(h);
-		const kVector<V>& resu = myResu(h);
-		kVector<V>& resh = res(h);
-		for(i=0;i<myX.size();++i)
+		//	down: resd(i) = (Bu(i,0) F(i) + Bu(i,1) F(i+1) - Cd(i,0) resd(i-1)) / Cd(i,1)
+		i  = k;
+		a0 = myBu(i,0);
+		a1 = myBu(i,1);
+		c  = myCd(i,0);
+		b  = myPd(i);
 		{
-			resh(i) = 0.5*(resd(i) + resu(i));
+			const V* fi = &F(i,0);
+			const V* fu = i<n ? &F(i+1,0) : nullptr;
+			const V* dl = i>0 ? &myResd(i-1,0) : nullptr;
+			V* di = &myResd(i,0);
+			V ve;
+			for(h=0;h<numV;++h)
+			{
+				ve = a0*fi[h];
+				if(fu) ve += a1*fu[h];
+				di[h] = dl ? (ve - c*dl[h])*b : ve*b;
+			}
+			if(i>n-k)
+			{
+				const V* ui = &myResu(i,0);
+				V* f = &F(i,0);
+				for(h=0;h<numV;++h) f[h] = 0.5*(di[h] + ui[h]);
+			}
+		}
+
+		//	up: resu(j) = (Bd(j,0) F(j-1) + Bd(j,1) F(j) - Cu(j,1) resu(j+1)) / Cu(j,0)
+		j  = n-k;
+		a0 = myBd(j,0);
+		a1 = myBd(j,1);
+		c  = myCu(j,1);
+		b  = myPu(j);
+		{
+			const V* fl = j>0 ? &F(j-1,0) : nullptr;
+			const V* fj = &F(j,0);
+			const V* uu = j<n ? &myResu(j+1,0) : nullptr;
+			V* uj = &myResu(j,0);
+			V ve;
+			for(h=0;h<numV;++h)
+			{
+				ve = fl ? a0*fl[h] + a1*fj[h] : a1*fj[h];
+				uj[h] = uu ? (ve - c*uu[h])*b : ve*b;
+			}
+			if(j<=k)
+			{
+				const V* dj = &myResd(j,0);
+				V* f = &F(j,0);
+				for(h=0;h<numV;++h) f[h] = 0.5*(dj[h] + uj[h]);
+			}
 		}
 	}
 
@@ -465,3 +774,68 @@ kAde<V>::rollFwd(
 	return;
 }
 
+//	interleaved sweeps fwd
+template <class V>
+void
+kAde<V>::interleavedFwd(
+	kMatrixView<V>			F)
+{
+	//	dims
+	int n = F.rows() - 1;
+	int numV = F.cols();
+
+	//	helps
+	int k, i, j, h;
+	V c, b, a0, a1, e0, e1;
+
+	//	implicit (d) from the bottom into Ve, implicit (u) from the top into Vu
+	for(k=0;k<=n;++k)
+	{
+		i = k;
+		c = myCd(i,0);
+		b = myPd(i);
+		{
+			const V* fi = &F(i,0);
+			const V* vl = i>0 ? &myVe(i-1,0) : nullptr;
+			V* vi = &myVe(i,0);
+			if(vl)	for(h=0;h<numV;++h) vi[h] = (fi[h] - c*vl[h])*b;
+			else	for(h=0;h<numV;++h) vi[h] = fi[h]*b;
+		}
+
+		j = n-k;
+		c = myCu(j,1);
+		b = myPu(j);
+		{
+			const V* fj = &F(j,0);
+			const V* vu = j<n ? &myVu(j+1,0) : nullptr;
+			V* vj = &myVu(j,0);
+			if(vu)	for(h=0;h<numV;++h) vj[h] = (fj[h] - c*vu[h])*b;
+			else	for(h=0;h<numV;++h) vj[h] = fj[h]*b;
+		}
+	}
+
+	//	explicit (d) on Vu, explicit (u) on Ve and average
+	for(i=0;i<=n;++i)
+	{
+		a0 = myBd(i,0);
+		a1 = myBd(i,1);
+		e0 = myBu(i,0);
+		e1 = myBu(i,1);
+		const V* ul = i>0 ? &myVu(i-1,0) : nullptr;
+		const V* ui = &myVu(i,0);
+		const V* di = &myVe(i,0);
+		const V* du = i<n ? &myVe(i+1,0) : nullptr;
+		V* f = &F(i,0);
+		V rd, ru;
+		for(h=0;h<numV;++h)
+		{
+			rd = ul ? a0*ul[h] + a1*ui[h] : a1*ui[h];
+			ru = e0*di[h];
+			if(du) ru += e1*du[h];
+			f[h] = 0.5*(rd + ru);
+		}
+	}
+
+	//	done
+	return;
+}
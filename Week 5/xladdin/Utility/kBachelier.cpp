@@ -1,6 +1,9 @@
 #include "kBachelier.h"
 #include "kSolver.h"
 #include "kFd1d.h"
+#include "kFd1dBatch.h"
+#include "kFdGrid.h"
+#include <limits>
 
 class kBachelierObj : public kSolverObjective
 {
@@ -78,33 +81,18 @@ kBachelier::implied(
 	return volatility;
 }
 
-//	fd runner
-bool	
-kBachelier::fdRunner(
+//	fd grid: equidistant s axis spanning +/- numStd std
+void
+kBachelier::fdGrid(
 	const double		s0,
-	const double		r,
-	const double		mu,
 	const double		sigma,
 	const double		expiry,
-	const double		strike,
-	const bool			dig,
-	const int			pc,			//	put (-1) call (1)
-	const int			ea,			//	european (0), american (1)
-	const int			smooth,		//	smoothing
-	const double		theta,
-	const int			wind,
 	const double		numStd,
-	const int			numT,
 	const int			numS,
-	const bool			update,
-	const int			numPr,
-	double&				res0,
-	kVector<double>&	s,
-	kVector<double>&	res,
-	string&				error)
+	kVector<double>&	s)
 {
 	//	helps
-	int h, i, p;
+	int i;
 
 	//	construct s axis
 	double t    = max(0.0, expiry);
@@ -128,39 +116,102 @@ kBachelier::fdRunner(
 		s(i) = s(i-1) + ds;
 	}
 
+	//	done
+	return;
+}
+
+//	fd grid concentrated around s0 and strike
+bool
+kBachelier::fdGrid(
+	const double		s0,
+	const double		sigma,
+	const double		expiry,
+	const double		numStd,
+	const int			numS,
+	const double		strike,
+	const bool			dig,
+	const double		conc,
+	kVector<double>&	s,
+	int&				i0,
+	string&				error)
+{
+	//	equidistant
+	double t    = max(0.0, expiry);
+	double std  = sigma * sqrt(t);
+	int    nums = 2*(numS/2);
+	if(conc<=0.0 || nums<2 || std<=0.0)
+	{
+		fdGrid(s0, sigma, t, numStd, numS, s);
+		i0 = s.size()/2;
+		return true;
+	}
+
+	//	concentrated over the same range, spot first
+	kVector<double> points(2);
+	kVector<int>	snap(2);
+	points(0) = s0;
+	points(1) = strike;
+	snap(0)	  = kFdGrid::node;
+	snap(1)	  = dig ? kFdGrid::mid : kFdGrid::node;
+	if(!kFdGrid::concentrated(s0 - numStd*std, s0 + numStd*std, nums,
+		points, snap, conc * std, s, error)) return false;
+	i0 = kFdGrid::index(s, s0);
+
+	//	done
+	return true;
+}
+
+//	roll on grid s, result at node i0
+template <class G>
+static void
+fdRoll(
+	const kVector<double>&	s,
+	const int				i0,
+	const double			r,
+	const double			mu,
+	const double			sigma,
+	const double			t,
+	const double			strike,
+	const bool				dig,
+	const int				pc,
+	const int				ea,
+	const int				smooth,
+	const double			theta,
+	const int				wind,
+	const int				numT,
+	const bool				update,
+	const int				numPr,
+	kFd1d<double,G>&		fd,
+	double&					res0,
+	kVector<double>&		res,
+	const double			s0,
+	kVector<double>*		greeks0,
+	kMatrix<double>*		greeks)
+{
+	//	helps
+	int h, i, p;
+	int nums = s.size();
+
 	//	construct fd grid
-	kFd1d<double> fd;
 	fd.init(1, s, false);
 
 	//	set terminal result
-	double xl, xu;
-	res.resize(nums);
-	for(i=0;i<nums;++i)
-	{
-		if(smooth==0 || i==0 || i==nums-1)
-		{
-			if(dig) res(i) = 0.5*(kInlines::sign(s(i)-strike)+1.0);
-			else    res(i) = max(0.0, s(i) - strike);
-		}
-		else
-		{
-			xl = 0.5 * (s(i - 1) + s(i));
-			xu = 0.5 * (s(i) + s(i + 1));
-			if (dig) res(i) = kFiniteDifference::smoothDigital(xl, xu, strike);
-			else	 res(i) = kFiniteDifference::smoothCall(xl, xu, strike);
-		}
-
-		if(pc<0)
-		{
-			if(dig) res(i) =  1.0 - res(i);
-			else    res(i) -= (s(i) - strike);
-		}
-	}
+	kFiniteDifference::vanillaPayoff(s, strike, dig, pc, smooth, res);
 
 	//	time steps
 	int    numt = max(0, numT);
 	double dt   = t/max(1,numt);
 
+	//	american: projection after the step (1), in the implicit solve by brennan-schwartz (2) or penalty (3)
+	kSlotMatrix<double> obs;
+	if(ea==2 || ea==3) obs.resize(1, nums);
+	kSlotMatrix<double>* obstacle = ea==2 || ea==3 ? &obs : nullptr;
+	auto exercise = ea==3 ? kFd1d<double,G>::penalty : kFd1d<double,G>::brennanSchwartz;
+
+	//	greeks: results before the last two steps for theta
+	bool grk = greeks0 || greeks;
+	kVector<double> prev1, prev2;
+
 	//	repeat
 	int nump = max(1, numPr);
 	for(p=0;p<nump;++p)
@@ -174,22 +225,267 @@ kBachelier::fdRunner(
 		}
 
 		//	roll
-		fd.res()(0) = res;
+		fd.res().setSlot(0, res);
+		if(obstacle) obstacle->setSlot(0, res);
 		for (h = numt - 1; h >= 0; --h)
 		{
-			fd.rollBwd(dt, update || h==(numt-1), theta, wind, fd.res());
-			if(ea>0)
+			if(grk && h<2 && p==nump-1) fd.res().getSlot(0, h ? prev2 : prev1);
+			fd.rollBwd(dt, update || h==(numt-1), theta, wind, fd.res(), obstacle, exercise);
+			if(ea>0 && !obstacle)
 			{
-				for(i=0;i<nums;++i) fd.res()(0)(i) = max(res(i), fd.res()(0)(i));
+				for(i=0;i<nums;++i) fd.res()(0,i) = max(res(i), fd.res()(0,i));
 			}
 		}
 	}
 
 	//	set result
-	res  = fd.res()(0);
-	res0 = fd.res()(0)(nums/2);
+	fd.res().getSlot(0, res);
+	res0 = fd.res()(0, i0);
+
+	//	greeks
+	if(grk)
+	{
+		kMatrix<double> g;
+		kMatrix<double>& gr = greeks ? *greeks : g;
+		fd.greeks(0, numt>0 ? &prev1 : nullptr, numt>1 ? &prev2 : nullptr, dt, gr);
+		if(greeks0) kFiniteDifference::interpolate(s, gr, s0, *greeks0);
+	}
+
+	//	done
+	return;
+}
+
+//	fd runner
+bool	
+kBachelier::fdRunner(
+	const double		s0,
+	const double		r,
+	const double		mu,
+	const double		sigma,
+	const double		expiry,
+	const double		strike,
+	const bool			dig,
+	const int			pc,			//	put (-1) call (1)
+	const int			ea,			//	european (0), american (1: projection, 2: brennan-schwartz, 3: penalty)
+	const int			smooth,		//	smoothing
+	const double		theta,
+	const int			wind,
+	const double		numStd,
+	const int			numT,
+	const int			numS,
+	const bool			update,
+	const int			numPr,
+	double&				res0,
+	kVector<double>&	s,
+	kVector<double>&	res,
+	string&				error,
+	const double		conc,
+	kVector<double>*	greeks0,
+	kMatrix<double>*	greeks)
+{
+	//	local workspace, concentrated grids are non uniform
+	if(conc>0.0)
+	{
+		kFd1d<double,kGridGeneral> fd;
+		return fdRunner(s0, r, mu, sigma, expiry, strike, dig, pc, ea, smooth, theta, wind, numStd, numT, numS, update, numPr, fd, res0, s, res, error, conc, greeks0, greeks);
+	}
+
+	kFd1d<double,kGridUniform> fd;
+	return fdRunner(s0, r, mu, sigma, expiry, strike, dig, pc, ea, smooth, theta, wind, numStd, numT, numS, update, numPr, fd, res0, s, res, error, greeks0, greeks);
+}
+
+//	fd runner, reusing workspace fd
+bool	
+kBachelier::fdRunner(
+	const double		s0,
+	const double		r,
+	const double		mu,
+	const double		sigma,
+	const double		expiry,
+	const double		strike,
+	const bool			dig,
+	const int			pc,			//	put (-1) call (1)
+	const int			ea,			//	european (0), american (1: projection, 2: brennan-schwartz, 3: penalty)
+	const int			smooth,		//	smoothing
+	const double		theta,
+	const int			wind,
+	const double		numStd,
+	const int			numT,
+	const int			numS,
+	const bool			update,
+	const int			numPr,
+	kFd1d<double,kGridUniform>&	fd,
+	double&				res0,
+	kVector<double>&	s,
+	kVector<double>&	res,
+	string&				error,
+	kVector<double>*	greeks0,
+	kMatrix<double>*	greeks)
+{
+	//	construct s axis
+	double t = max(0.0, expiry);
+	fdGrid(s0, sigma, t, numStd, numS, s);
+
+	//	roll
+	fdRoll(s, s.size()/2, r, mu, sigma, t, strike, dig, pc, ea, smooth, theta, wind, numT, update, numPr, fd, res0, res, s0, greeks0, greeks);
 
 	//	done
 	return true;
 }
 
+//	fd runner on a concentrated grid, reusing workspace fd
+bool	
+kBachelier::fdRunner(
+	const double		s0,
+	const double		r,
+	const double		mu,
+	const double		sigma,
+	const double		expiry,
+	const double		strike,
+	const bool			dig,
+	const int			pc,			//	put (-1) call (1)
+	const int			ea,			//	european (0), american (1: projection, 2: brennan-schwartz, 3: penalty)
+	const int			smooth,		//	smoothing
+	const double		theta,
+	const int			wind,
+	const double		numStd,
+	const int			numT,
+	const int			numS,
+	const bool			update,
+	const int			numPr,
+	kFd1d<double,kGridGeneral>&	fd,
+	double&				res0,
+	kVector<double>&	s,
+	kVector<double>&	res,
+	string&				error,
+	const double		conc,
+	kVector<double>*	greeks0,
+	kMatrix<double>*	greeks)
+{
+	//	construct s axis
+	int i0;
+	double t = max(0.0, expiry);
+	if(!fdGrid(s0, sigma, t, numStd, numS, strike, dig, conc, s, i0, error)) return false;
+
+	//	roll
+	fdRoll(s, i0, r, mu, sigma, t, strike, dig, pc, ea, smooth, theta, wind, numT, update, numPr, fd, res0, res, s0, greeks0, greeks);
+
+	//	done
+	return true;
+}
+
+//	fd runner batch
+bool
+kBachelier::fdRunnerBatch(
+	const kVector<double>&	s0,
+	const kVector<double>&	r,
+	const kVector<double>&	mu,
+	const kVector<double>&	sigma,
+	const kVector<double>&	expiry,
+	const kVector<double>&	strike,
+	const kVector<int>&		dig,
+	const kVector<int>&		pc,			//	put (-1) call (1)
+	const kVector<int>&		ea,			//	european (0), american (1: projection, 2: brennan-schwartz, 3: penalty)
+	const int				smooth,		//	smoothing
+	const double			theta,
+	const int				wind,
+	const double			numStd,
+	const int				numT,
+	const int				numS,
+	kVector<double>&		res0,
+	string&					error)
+{
+	//	lanes
+	const int W = kFd1dBatch<double>::numW;
+
+	//	check dims
+	int numTr = s0.size();
+	if(r.size()!=numTr || mu.size()!=numTr || sigma.size()!=numTr || expiry.size()!=numTr
+		|| strike.size()!=numTr || dig.size()!=numTr || pc.size()!=numTr || ea.size()!=numTr)
+	{
+		error = "kBachelier::fdRunnerBatch: trade inputs must have the same size";
+		return false;
+	}
+
+	//	helps
+	int b, h, i, l, w;
+	double t, res0l;
+	kVector<double> s, payoff, res, dt(W);
+
+	//	trades with a degenerate grid or exercise in the implicit solve (ea 2, 3) go through the scalar runner
+	res0.resize(numTr);
+	kVector<int> idx;
+	for(l=0;l<numTr;++l)
+	{
+		t = max(0.0, expiry(l));
+		if(numS>=2 && sigma(l)*sqrt(t)>0.0 && ea(l)!=2 && ea(l)!=3)
+		{
+			idx.push_back(l);
+		}
+		else
+		{
+			if(!fdRunner(s0(l), r(l), mu(l), sigma(l), expiry(l), strike(l), dig(l)>0, pc(l), ea(l), smooth,
+				theta, wind, numStd, numT, numS, true, 1, res0l, s, res, error)) return false;
+			res0(l) = res0l;
+		}
+	}
+
+	//	dims
+	int numt = max(0, numT);
+	int nums = 2*(numS/2) + 1;
+
+	//	fd batch
+	kFd1dBatch<double> fd;
+	fd.init(nums);
+	kMatrix<double> obstacle(nums, W);
+
+	//	batches of W lanes, last batch padded with copies
+	int numI = idx.size();
+	for(b=0;b<numI;b+=W)
+	{
+		bool american = false;
+		for(w=0;w<W;++w)
+		{
+			l = idx(min(b+w, numI-1));
+			t = max(0.0, expiry(l));
+			dt(w) = t/max(1,numt);
+
+			//	grid
+			fdGrid(s0(l), sigma(l), t, numStd, numS, s);
+			fd.initLane(w, s, false);
+
+			//	parameters
+			for(i=0;i<nums;++i)
+			{
+				fd.r()(i,w)   = r(l);
+				fd.mu()(i,w)  = mu(l);
+				fd.var()(i,w) = sigma(l) * sigma(l);
+			}
+
+			//	terminal result and exercise
+			kFiniteDifference::vanillaPayoff(s, strike(l), dig(l)>0, pc(l), smooth, payoff);
+			for(i=0;i<nums;++i)
+			{
+				fd.res()(i,w)  = payoff(i);
+				obstacle(i,w) = ea(l)>0 ? payoff(i) : std::numeric_limits<double>::lowest();
+			}
+			american = american || ea(l)>0;
+		}
+
+		//	roll
+		for(h=numt-1;h>=0;--h)
+		{
+			fd.rollBwd(dt, h==(numt-1), theta, wind);
+			if(american) fd.project(obstacle);
+		}
+
+		//	set result
+		for(w=0;w<W && b+w<numI;++w)
+		{
+			res0(idx(b+w)) = fd.res()(nums/2, w);
+		}
+	}
+
+	//	done
+	return true;
+}
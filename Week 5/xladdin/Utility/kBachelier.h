@@ -8,6 +8,7 @@
 #include "kSpecialFunction.h"
 #include "kInlines.h"
 #include "kVector.h"
+#include "kMatrix.h"
 #include <cmath>
 #include <algorithm>
 #include <string>
@@ -15,6 +16,11 @@
 using std::max;
 using std::string;
 
+//	forward declaration
+struct kGridGeneral;
+struct kGridUniform;
+template <class V, class G> class kFd1d;
+
 //	class
 class kBachelier
 {
@@ -43,7 +49,34 @@ public:
 		double	price,
 		double	forward);
 
-	//	fd runner
+	//	fd grid
+	static void	fdGrid(
+		const double		s0,
+		const double		sigma,
+		const double		expiry,
+		const double		numStd,
+		const int			numS,
+		kVector<double>&	s);
+
+	//	fd grid concentrated around s0 and strike with width conc std, s0 on
+	//	node i0, the strike on a node (midpoint for digitals). conc <= 0 for
+	//	the equidistant grid
+	static bool	fdGrid(
+		const double		s0,
+		const double		sigma,
+		const double		expiry,
+		const double		numStd,
+		const int			numS,
+		const double		strike,
+		const bool			dig,
+		const double		conc,
+		kVector<double>&	s,
+		int&				i0,
+		string&				error);
+
+	//	fd runner, conc > 0 on a concentrated grid. greeks from the grid of
+	//	the same run if asked for: delta and gamma from the central stencils,
+	//	theta from the last step, interpolated to s0 (cubic) off the nodes
 	static bool	fdRunner(
 		const double		s0,
 		const double		r,
@@ -53,7 +86,7 @@ public:
 		const double		strike,
 		const bool			dig,
 		const int			pc,			//	put (-1) call (1)
-		const int			ea,			//	european (0), american (1)
+		const int			ea,			//	european (0), american (1: projection, 2: brennan-schwartz, 3: penalty)
 		const int			smooth,		//	smoothing
 		const double		theta,
 		const int			wind,
@@ -65,7 +98,85 @@ public:
 		double&				res0,
 		kVector<double>&	s,
 		kVector<double>&	res,
-		string&				error);
+		string&				error,
+		const double		conc = 0.0,		//	grid concentration, see fdGrid
+		kVector<double>*	greeks0 = nullptr,	//	delta, gamma, theta at s0
+		kMatrix<double>*	greeks = nullptr);	//	numx x 3 delta, gamma, theta on the grid
+
+	//	fd runner, reusing workspace fd
+	static bool	fdRunner(
+		const double		s0,
+		const double		r,
+		const double		mu,
+		const double		sigma,
+		const double		expiry,
+		const double		strike,
+		const bool			dig,
+		const int			pc,			//	put (-1) call (1)
+		const int			ea,			//	european (0), american (1: projection, 2: brennan-schwartz, 3: penalty)
+		const int			smooth,		//	smoothing
+		const double		theta,
+		const int			wind,
+		const double		numStd,
+		const int			numt,
+		const int			numx,
+		const bool			update,
+		const int			numPr,
+		kFd1d<double,kGridUniform>&	fd,
+		double&				res0,
+		kVector<double>&	s,
+		kVector<double>&	res,
+		string&				error,
+		kVector<double>*	greeks0 = nullptr,	//	delta, gamma, theta at s0
+		kMatrix<double>*	greeks = nullptr);	//	numx x 3 delta, gamma, theta on the grid
+
+	//	fd runner on a concentrated grid, reusing workspace fd
+	static bool	fdRunner(
+		const double		s0,
+		const double		r,
+		const double		mu,
+		const double		sigma,
+		const double		expiry,
+		const double		strike,
+		const bool			dig,
+		const int			pc,			//	put (-1) call (1)
+		const int			ea,			//	european (0), american (1: projection, 2: brennan-schwartz, 3: penalty)
+		const int			smooth,		//	smoothing
+		const double		theta,
+		const int			wind,
+		const double		numStd,
+		const int			numt,
+		const int			numx,
+		const bool			update,
+		const int			numPr,
+		kFd1d<double,kGridGeneral>&	fd,
+		double&				res0,
+		kVector<double>&	s,
+		kVector<double>&	res,
+		string&				error,
+		const double		conc,
+		kVector<double>*	greeks0 = nullptr,	//	delta, gamma, theta at s0
+		kMatrix<double>*	greeks = nullptr);	//	numx x 3 delta, gamma, theta on the grid
+
+	//	fd runner batch: trades rolled in lockstep lanes of kFd1dBatch, common grid tech
+	static bool	fdRunnerBatch(
+		const kVector<double>&	s0,
+		const kVector<double>&	r,
+		const kVector<double>&	mu,
+		const kVector<double>&	sigma,
+		const kVector<double>&	expiry,
+		const kVector<double>&	strike,
+		const kVector<int>&		dig,
+		const kVector<int>&		pc,			//	put (-1) call (1)
+		const kVector<int>&		ea,			//	european (0), american (1: projection, 2: brennan-schwartz, 3: penalty)
+		const int				smooth,		//	smoothing
+		const double			theta,
+		const int				wind,
+		const double			numStd,
+		const int				numt,
+		const int				numx,
+		kVector<double>&		res0,
+		string&					error);
 	
 
 };
@@ -1,6 +1,10 @@
 #include "kBlack.h"
 #include "kSolver.h"
 #include "kFd1d.h"
+#include "kFd1dBatch.h"
+#include "kThreadPool.h"
+#include "kFdGrid.h"
+#include <limits>
 
 class kBlackObj : public kSolverObjective
 {
@@ -63,9 +67,10 @@ kBlack::implied(
 	//	objective
 	kBlackObj obj(expiry, strike, price, forward);
 
-	//	start guess
-	double volatility = 0.1;
-	int    numIter = 10;
+	//	start guess at the inflection point of the price in the volatility,
+	//	from there the newton iterates approach the root monotonically
+	double volatility = expiry>0.0 && forward!=strike ? sqrt(2.0 * fabs(log(forward / strike)) / expiry) : 0.1;
+	int    numIter = 50;
 	double epsilon = (price - intrinc) * kConstants::epsilon();
 
 	//	solve
@@ -78,33 +83,18 @@ kBlack::implied(
 	return volatility;
 }
 
-//	fd runner
-bool
-kBlack::fdRunner(
+//	fd grid: log equidistant s axis spanning +/- numStd std
+void
+kBlack::fdGrid(
 	const double		s0,
-	const double		r,
-	const double		mu,
 	const double		sigma,
 	const double		expiry,
-	const double		strike,
-	const bool			dig,
-	const int			pc,			//	put (-1) call (1)
-	const int			ea,			//	european (0), american (1)
-	const int			smooth,		//	smoothing
-	const double		theta,
-	const int			wind,
 	const double		numStd,
-	const int			numT,
 	const int			numS,
-	const bool			update,
-	const int			numPr,
-	double&				res0,
-	kVector<double>&	s,
-	kVector<double>&	res,
-	string&				error)
+	kVector<double>&	s)
 {
 	//	helps
-	int h, i, p;
+	int i;
 
 	//	construct s axis
 	double t = max(0.0, expiry);
@@ -129,39 +119,142 @@ kBlack::fdRunner(
 		s(i) = s(i - 1) * ds;
 	}
 
-	//	construct fd grid
+	//	done
+	return;
+}
+
+//	fd grid concentrated around s0 and strike
+bool
+kBlack::fdGrid(
+	const double		s0,
+	const double		sigma,
+	const double		expiry,
+	const double		numStd,
+	const int			numS,
+	const double		strike,
+	const bool			dig,
+	const double		conc,
+	kVector<double>&	s,
+	int&				i0,
+	string&				error)
+{
+	//	log equidistant
+	double t   = max(0.0, expiry);
+	double std = sigma * sqrt(t);
+	int    nums = 2 * (numS / 2);
+	if(conc<=0.0 || nums<2 || std<=0.0)
+	{
+		fdGrid(s0, sigma, t, numStd, numS, s);
+		i0 = s.size() / 2;
+		return true;
+	}
+
+	//	concentrated over the same range, spot first
+	kVector<double> points(2);
+	kVector<int>	snap(2);
+	points(0) = s0;
+	points(1) = strike;
+	snap(0)	  = kFdGrid::node;
+	snap(1)	  = dig ? kFdGrid::mid : kFdGrid::node;
+	if(!kFdGrid::concentrated(s0 * exp(-numStd * std), s0 * exp(numStd * std), nums,
+		points, snap, conc * s0 * std, s, error)) return false;
+	i0 = kFdGrid::index(s, s0);
+
+	//	done
+	return true;
+}
+
+//	fd runner
+bool
+kBlack::fdRunner(
+	const double		s0,
+	const double		r,
+	const double		mu,
+	const double		sigma,
+	const double		expiry,
+	const double		strike,
+	const bool			dig,
+	const int			pc,			//	put (-1) call (1)
+	const int			ea,			//	european (0), american (1: projection, 2: brennan-schwartz, 3: penalty)
+	const int			smooth,		//	smoothing
+	const double		theta,
+	const int			wind,
+	const double		numStd,
+	const int			numT,
+	const int			numS,
+	const bool			update,
+	const int			numPr,
+	double&				res0,
+	kVector<double>&	s,
+	kVector<double>&	res,
+	string&				error,
+	const double		conc,
+	kVector<double>*	greeks0,
+	kMatrix<double>*	greeks)
+{
+	//	local workspace
 	kFd1d<double> fd;
+
+	return fdRunner(s0, r, mu, sigma, expiry, strike, dig, pc, ea, smooth, theta, wind, numStd, numT, numS, update, numPr, fd, res0, s, res, error, conc, greeks0, greeks);
+}
+
+//	fd runner, reusing workspace fd
+bool
+kBlack::fdRunner(
+	const double		s0,
+	const double		r,
+	const double		mu,
+	const double		sigma,
+	const double		expiry,
+	const double		strike,
+	const bool			dig,
+	const int			pc,			//	put (-1) call (1)
+	const int			ea,			//	european (0), american (1: projection, 2: brennan-schwartz, 3: penalty)
+	const int			smooth,		//	smoothing
+	const double		theta,
+	const int			wind,
+	const double		numStd,
+	const int			numT,
+	const int			numS,
+	const bool			update,
+	const int			numPr,
+	kFd1d<double>&		fd,
+	double&				res0,
+	kVector<double>&	s,
+	kVector<double>&	res,
+	string&				error,
+	const double		conc,
+	kVector<double>*	greeks0,
+	kMatrix<double>*	greeks)
+{
+	//	helps
+	int h, i, p, i0;
+
+	//	construct s axis
+	double t = max(0.0, expiry);
+	if(!fdGrid(s0, sigma, t, numStd, numS, strike, dig, conc, s, i0, error)) return false;
+	int nums = s.size();
+
+	//	construct fd grid
 	fd.init(1, s, false);
 
 	//	set terminal result
-	double sl, su;
-	res.resize(nums);
-	for (i = 0; i < nums; ++i)
-	{
-		if (smooth == 0 || i == 0 || i == nums - 1)
-		{
-			if (dig) res(i) = 0.5 * (kInlines::sign(s(i) - strike) + 1.0);
-			else    res(i) = max(0.0, s(i) - strike);
-		}
-		else
-		{
-			sl = 0.5 * (s(i - 1) + s(i));
-			su = 0.5 * (s(i) + s(i + 1));
-			if (dig) res(i) = kFiniteDifference::smoothDigital(sl, su, strike);
-			else	res(i) = kFiniteDifference::smoothCall(sl, su, strike);
-		}
-
-		if (pc < 0)
-		{
-			if (dig) res(i) = 1.0 - res(i);
-			else    res(i) -= (s(i) - strike);
-		}
-	}
+	kFiniteDifference::vanillaPayoff(s, strike, dig, pc, smooth, res);
 
 	//	time steps
 	int    numt = max(0, numT);
 	double dt = t / max(1, numt);
 
+	//	american: projection after the step (1), in the implicit solve by brennan-schwartz (2) or penalty (3)
+	kSlotMatrix<double> obs;
+	if(ea==2 || ea==3) obs.resize(1, nums);
+	kSlotMatrix<double>* obstacle = ea==2 || ea==3 ? &obs : nullptr;
+	auto exercise = ea==3 ? kFd1d<double>::penalty : kFd1d<double>::brennanSchwartz;
+
+	//	greeks: results before the last two steps for theta
+	bool grk = greeks0 || greeks;
+	kVector<double> prev1, prev2;
+
 	//	repeat
 	int nump = max(1, numPr);
 	for (p = 0; p < nump; ++p)
@@ -175,20 +268,280 @@ kBlack::fdRunner(
 		}
 
 		//	roll
-		fd.res()(0) = res;
+		fd.res().setSlot(0, res);
+		if(obstacle) obstacle->setSlot(0, res);
 		for (h = numt - 1; h >= 0; --h)
 		{
-			fd.rollBwd(dt, update || h == (numt - 1), theta, wind, fd.res());
-			if (ea > 0)
+			if(grk && h<2 && p==nump-1) fd.res().getSlot(0, h ? prev2 : prev1);
+			fd.rollBwd(dt, update || h == (numt - 1), theta, wind, fd.res(), obstacle, exercise);
+			if (ea > 0 && !obstacle)
 			{
-				for (i = 0; i < nums; ++i) fd.res()(0)(i) = max(res(i), fd.res()(0)(i));
+				for (i = 0; i < nums; ++i) fd.res()(0,i) = max(res(i), fd.res()(0,i));
 			}
 		}
 	}
 
 	//	set result
-	res = fd.res()(0);
-	res0 = fd.res()(0)(nums / 2);
+	fd.res().getSlot(0, res);
+	res0 = fd.res()(0, i0);
+
+	//	greeks
+	if(grk)
+	{
+		kMatrix<double> g;
+		kMatrix<double>& gr = greeks ? *greeks : g;
+		fd.greeks(0, numt>0 ? &prev1 : nullptr, numt>1 ? &prev2 : nullptr, dt, gr);
+		if(greeks0) kFiniteDifference::interpolate(s, gr, s0, *greeks0);
+	}
+
+	//	done
+	return true;
+}
+
+//	crank-nicolson run with rannacher start up, result at s0
+static double
+fdRannacher(
+	const double		s0,
+	const double		r,
+	const double		mu,
+	const double		sigma,
+	const double		expiry,
+	const double		strike,
+	const bool			dig,
+	const int			pc,
+	const int			ea,
+	const int			smooth,
+	const int			wind,
+	const double		numStd,
+	const int			numT,
+	const int			numS,
+	const int			numRan,
+	kFd1d<double>&		fd,
+	kVector<double>&	s,
+	kVector<double>&	payoff)
+{
+	//	helps
+	int h, i, k;
+
+	//	grid and parameters
+	double t = max(0.0, expiry);
+	kBlack::fdGrid(s0, sigma, t, numStd, numS, s);
+	int nums = s.size();
+	fd.init(1, s, false);
+	for(i=0;i<nums;++i)
+	{
+		fd.r()(i)	= r;
+		fd.mu()(i)	= mu * s(i);
+		fd.var()(i) = kInlines::sqr(sigma * s(i));
+	}
+
+	//	terminal result
+	kFiniteDifference::vanillaPayoff(s, strike, dig, pc, smooth, payoff);
+	fd.res().setSlot(0, payoff);
+
+	//	time steps
+	int    numt = max(0, numT);
+	int    numr = min(numt, max(0, numRan));
+	double dt	= t / max(1, numt);
+
+	//	american as in fdRunner
+	kSlotMatrix<double> obs;
+	if(ea==2 || ea==3)
+	{
+		obs.resize(1, nums);
+		obs.setSlot(0, payoff);
+	}
+	kSlotMatrix<double>* obstacle = ea==2 || ea==3 ? &obs : nullptr;
+	auto exercise = ea==3 ? kFd1d<double>::penalty : kFd1d<double>::brennanSchwartz;
+
+	//	roll, implicit half steps first
+	for(h=numt-1;h>=0;--h)
+	{
+		bool ran = h>=numt-numr;
+		for(k=0;k<(ran ? 2 : 1);++k)
+		{
+			fd.rollBwd(ran ? 0.5*dt : dt, h==numt-1 || h==numt-numr-1, ran ? 1.0 : 0.5, wind, fd.res(), obstacle, exercise);
+			if(ea>0 && !obstacle)
+			{
+				for(i=0;i<nums;++i) fd.res()(0,i) = max(payoff(i), fd.res()(0,i));
+			}
+		}
+	}
+
+	//	done
+	return fd.res()(0, nums/2);
+}
+
+//	fd runner with rannacher start up and richardson extrapolation
+bool
+kBlack::fdRunnerExtrap(
+	const double		s0,
+	const double		r,
+	const double		mu,
+	const double		sigma,
+	const double		expiry,
+	const double		strike,
+	const bool			dig,
+	const int			pc,			//	put (-1) call (1)
+	const int			ea,			//	european (0), american (1: projection, 2: brennan-schwartz, 3: penalty)
+	const int			smooth,		//	smoothing
+	const int			wind,
+	const double		numStd,
+	const int			numT,
+	const int			numS,
+	const int			numRan,		//	rannacher steps
+	double&				res0,
+	double&				err,
+	string&				error,
+	kThreadPool*		pool)
+{
+	//	check
+	if(numT<1 || numS<2)
+	{
+		error = "kBlack::fdRunnerExtrap: need numt >= 1 and numx >= 2";
+		return false;
+	}
+
+	//	numt even and numx a multiple of 4, so all grids nest around s0
+	int numt = 2*((numT+1)/2);
+	int numx = 4*max(1, numS/4);
+
+	//	runs in multiples of (numt/2, numx/2), heaviest first so it starts early
+	const int lt[5] = { 4, 4, 2, 2, 1 };
+	const int lx[5] = { 4, 2, 4, 2, 1 };
+	double v[5];
+
+	kThreadPool& tp = pool ? *pool : kThreadPool::global();
+	tp.parallelFor(5, [&](int k, int)
+	{
+		kFd1d<double> fd;
+		kVector<double> s, payoff;
+		v[k] = fdRannacher(s0, r, mu, sigma, expiry, strike, dig, pc, ea, smooth, wind, numStd,
+			lt[k]*numt/2, lx[k]*numx/2, numRan, fd, s, payoff);
+	});
+
+	//	V(dt,dx) = V + a dt^2 + b dx^2 + c dt^2 dx^2 + O(h^4)
+	res0 = (16.0*v[0] - 4.0*v[1] - 4.0*v[2] + v[3]) / 9.0;
+
+	//	error from the diagonal extrapolation one level coarser, O(h^4) so 16 times larger
+	double res1 = (4.0*v[3] - v[4]) / 3.0;
+	err	 = fabs(res0 - res1) / 15.0;
+
+	//	done
+	return true;
+}
+
+//	fd runner batch
+bool
+kBlack::fdRunnerBatch(
+	const kVector<double>&	s0,
+	const kVector<double>&	r,
+	const kVector<double>&	mu,
+	const kVector<double>&	sigma,
+	const kVector<double>&	expiry,
+	const kVector<double>&	strike,
+	const kVector<int>&		dig,
+	const kVector<int>&		pc,			//	put (-1) call (1)
+	const kVector<int>&		ea,			//	european (0), american (1: projection, 2: brennan-schwartz, 3: penalty)
+	const int				smooth,		//	smoothing
+	const double			theta,
+	const int				wind,
+	const double			numStd,
+	const int				numT,
+	const int				numS,
+	kVector<double>&		res0,
+	string&					error)
+{
+	//	lanes
+	const int W = kFd1dBatch<double>::numW;
+
+	//	check dims
+	int numTr = s0.size();
+	if(r.size()!=numTr || mu.size()!=numTr || sigma.size()!=numTr || expiry.size()!=numTr
+		|| strike.size()!=numTr || dig.size()!=numTr || pc.size()!=numTr || ea.size()!=numTr)
+	{
+		error = "kBlack::fdRunnerBatch: trade inputs must have the same size";
+		return false;
+	}
+
+	//	helps
+	int b, h, i, l, w;
+	double t, res0l;
+	kVector<double> s, payoff, res, dt(W);
+
+	//	trades with a degenerate grid or exercise in the implicit solve (ea 2, 3) go through the scalar runner
+	res0.resize(numTr);
+	kVector<int> idx;
+	for(l=0;l<numTr;++l)
+	{
+		t = max(0.0, expiry(l));
+		if(numS>=2 && sigma(l)*sqrt(t)>0.0 && ea(l)!=2 && ea(l)!=3)
+		{
+			idx.push_back(l);
+		}
+		else
+		{
+			if(!fdRunner(s0(l), r(l), mu(l), sigma(l), expiry(l), strike(l), dig(l)>0, pc(l), ea(l), smooth,
+				theta, wind, numStd, numT, numS, true, 1, res0l, s, res, error)) return false;
+			res0(l) = res0l;
+		}
+	}
+
+	//	dims
+	int numt = max(0, numT);
+	int nums = 2*(numS/2) + 1;
+
+	//	fd batch
+	kFd1dBatch<double> fd;
+	fd.init(nums);
+	kMatrix<double> obstacle(nums, W);
+
+	//	batches of W lanes, last batch padded with copies
+	int numI = idx.size();
+	for(b=0;b<numI;b+=W)
+	{
+		bool american = false;
+		for(w=0;w<W;++w)
+		{
+			l = idx(min(b+w, numI-1));
+			t = max(0.0, expiry(l));
+			dt(w) = t/max(1,numt);
+
+			//	grid
+			fdGrid(s0(l), sigma(l), t, numStd, numS, s);
+			fd.initLane(w, s, false);
+
+			//	parameters
+			for(i=0;i<nums;++i)
+			{
+				fd.r()(i,w)   = r(l);
+				fd.mu()(i,w)  = mu(l) * s(i);
+				fd.var()(i,w) = kInlines::sqr(sigma(l) * s(i));
+			}
+
+			//	terminal result and exercise
+			kFiniteDifference::vanillaPayoff(s, strike(l), dig(l)>0, pc(l), smooth, payoff);
+			for(i=0;i<nums;++i)
+			{
+				fd.res()(i,w)  = payoff(i);
+				obstacle(i,w) = ea(l)>0 ? payoff(i) : std::numeric_limits<double>::lowest();
+			}
+			american = american || ea(l)>0;
+		}
+
+		//	roll
+		for(h=numt-1;h>=0;--h)
+		{
+			fd.rollBwd(dt, h==(numt-1), theta, wind);
+			if(american) fd.project(obstacle);
+		}
+
+		//	set result
+		for(w=0;w<W && b+w<numI;++w)
+		{
+			res0(idx(b+w)) = fd.res()(nums/2, w);
+		}
+	}
 
 	//	done
 	return true;
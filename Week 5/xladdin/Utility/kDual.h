@@ -0,0 +1,169 @@
+#pragma once
+
+//	desc:	forward mode dual numbers with N tangents
+//
+//	a kDual<N> carries a value and its derivatives in N directions, so one
+//	pass through a V template gives the result and N directional derivatives.
+//	the tangent loops have a fixed trip count and no dependencies, they
+//	vectorize: N = 4 fills an avx register, 8 two of them. seed direction i
+//	with kDual<N>(x, i), read back with value() and der(i)
+//
+//	the math functions, max and min are hidden friends found by argument
+//	dependent lookup next to the double versions, so the V templates of the
+//	library compile for kDual unchanged. <, >, <=, >= and comparisons with
+//	doubles look at the value. == and != between two duals compare value and
+//	tangents, so operator caches testing their inputs for change see a change
+//	of direction too
+//
+
+//	includes
+#include <cmath>
+
+//	class declaration
+template <int N>
+class kDual
+{
+public:
+
+	//	number of tangents
+	static constexpr int	numD = N;
+
+	//	c'tors: zero, constant, variable seeded in direction i
+	kDual() : myV(0.0) { setD(0.0); }
+	kDual(double v) : myV(v) { setD(0.0); }
+	kDual(double v, int i) : myV(v) { setD(0.0); myD[i] = 1.0; }
+
+	//	access
+	double			value()		 const	{ return myV; }
+	double			der(int i)	 const	{ return myD[i]; }
+	double&			value()				{ return myV; }
+	double&			der(int i)			{ return myD[i]; }
+
+	//	assign
+	kDual&	operator+=(const kDual& b)	{ myV += b.myV; for(int k=0;k<N;++k) myD[k] += b.myD[k]; return *this; }
+	kDual&	operator-=(const kDual& b)	{ myV -= b.myV; for(int k=0;k<N;++k) myD[k] -= b.myD[k]; return *this; }
+	kDual&	operator*=(const kDual& b)
+	{
+		for(int k=0;k<N;++k) myD[k] = myD[k]*b.myV + myV*b.myD[k];
+		myV *= b.myV;
+		return *this;
+	}
+	kDual&	operator/=(const kDual& b)
+	{
+		double bi = 1.0/b.myV;
+		myV *= bi;
+		for(int k=0;k<N;++k) myD[k] = (myD[k] - myV*b.myD[k])*bi;
+		return *this;
+	}
+
+	kDual&	operator+=(double b)	{ myV += b; return *this; }
+	kDual&	operator-=(double b)	{ myV -= b; return *this; }
+	kDual&	operator*=(double b)	{ myV *= b; for(int k=0;k<N;++k) myD[k] *= b; return *this; }
+	kDual&	operator/=(double b)	{ return *this *= 1.0/b; }
+
+	//	sign
+	friend kDual	operator+(const kDual& a)	{ return a; }
+	friend kDual	operator-(const kDual& a)	{ return a.chain(-a.myV, -1.0); }
+
+	//	arithmetic
+	friend kDual	operator+(kDual a, const kDual& b)	{ return a += b; }
+	friend kDual	operator-(kDual a, const kDual& b)	{ return a -= b; }
+	friend kDual	operator*(kDual a, const kDual& b)	{ return a *= b; }
+	friend kDual	operator/(kDual a, const kDual& b)	{ return a /= b; }
+
+	friend kDual	operator+(kDual a, double b)		{ return a += b; }
+	friend kDual	operator-(kDual a, double b)		{ return a -= b; }
+	friend kDual	operator*(kDual a, double b)		{ return a *= b; }
+	friend kDual	operator/(kDual a, double b)		{ return a /= b; }
+
+	friend kDual	operator+(double a, kDual b)		{ return b += a; }
+	friend kDual	operator-(double a, const kDual& b)	{ return b.chain(a - b.myV, -1.0); }
+	friend kDual	operator*(double a, kDual b)		{ return b *= a; }
+	friend kDual	operator/(double a, const kDual& b)
+	{
+		double v = a/b.myV;
+		return b.chain(v, -v/b.myV);
+	}
+
+	//	compare values
+	friend bool		operator<(const kDual& a, const kDual& b)	{ return a.myV<b.myV; }
+	friend bool		operator>(const kDual& a, const kDual& b)	{ return a.myV>b.myV; }
+	friend bool		operator<=(const kDual& a, const kDual& b)	{ return a.myV<=b.myV; }
+	friend bool		operator>=(const kDual& a, const kDual& b)	{ return a.myV>=b.myV; }
+
+	friend bool		operator<(const kDual& a, double b)		{ return a.myV<b; }
+	friend bool		operator>(const kDual& a, double b)		{ return a.myV>b; }
+	friend bool		operator<=(const kDual& a, double b)	{ return a.myV<=b; }
+	friend bool		operator>=(const kDual& a, double b)	{ return a.myV>=b; }
+	friend bool		operator==(const kDual& a, double b)	{ return a.myV==b; }
+	friend bool		operator!=(const kDual& a, double b)	{ return a.myV!=b; }
+
+	friend bool		operator<(double a, const kDual& b)		{ return a<b.myV; }
+	friend bool		operator>(double a, const kDual& b)		{ return a>b.myV; }
+	friend bool		operator<=(double a, const kDual& b)	{ return a<=b.myV; }
+	friend bool		operator>=(double a, const kDual& b)	{ return a>=b.myV; }
+	friend bool		operator==(double a, const kDual& b)	{ return a==b.myV; }
+	friend bool		operator!=(double a, const kDual& b)	{ return a!=b.myV; }
+
+	//	compare values and tangents
+	friend bool		operator==(const kDual& a, const kDual& b)
+	{
+		bool eq = a.myV==b.myV;
+		for(int k=0;k<N;++k) eq &= a.myD[k]==b.myD[k];
+		return eq;
+	}
+	friend bool		operator!=(const kDual& a, const kDual& b)	{ return !(a==b); }
+
+	//	math functions
+	friend kDual	exp(const kDual& a)
+	{
+		double v = std::exp(a.myV);
+		return a.chain(v, v);
+	}
+	friend kDual	log(const kDual& a)				{ return a.chain(std::log(a.myV), 1.0/a.myV); }
+	friend kDual	sqrt(const kDual& a)
+	{
+		double v = std::sqrt(a.myV);
+		return a.chain(v, 0.5/v);
+	}
+	friend kDual	cbrt(const kDual& a)
+	{
+		double v = std::cbrt(a.myV);
+		return a.chain(v, 1.0/(3.0*v*v));
+	}
+	friend kDual	pow(const kDual& a, double p)	{ return a.chain(std::pow(a.myV, p), p*std::pow(a.myV, p - 1.0)); }
+	friend kDual	erfc(const kDual& a)
+	{
+		const double twoOverSqrtPi = 1.1283791670955126;
+		return a.chain(std::erfc(a.myV), -twoOverSqrtPi*std::exp(-a.myV*a.myV));
+	}
+	friend kDual	fabs(const kDual& a)			{ return a.myV<0.0 ? -a : a; }
+	friend kDual	abs(const kDual& a)				{ return fabs(a); }
+
+	//	max and min, the tangents of the larger (smaller), the first on ties
+	friend kDual	max(const kDual& a, const kDual& b)	{ return a.myV<b.myV ? b : a; }
+	friend kDual	max(const kDual& a, double b)		{ return a.myV<b ? kDual(b) : a; }
+	friend kDual	max(double a, const kDual& b)		{ return a<b.myV ? b : kDual(a); }
+	friend kDual	min(const kDual& a, const kDual& b)	{ return b.myV<a.myV ? b : a; }
+	friend kDual	min(const kDual& a, double b)		{ return b<a.myV ? kDual(b) : a; }
+	friend kDual	min(double a, const kDual& b)		{ return b.myV<a ? b : kDual(a); }
+
+private:
+
+	//	f(a) from its value v and derivative d
+	kDual	chain(double v, double d) const
+	{
+		kDual res;
+		res.myV = v;
+		for(int k=0;k<N;++k) res.myD[k] = d*myD[k];
+		return res;
+	}
+
+	//	set tangents
+	void	setD(double d) { for(int k=0;k<N;++k) myD[k] = d; }
+
+	//	tangents first: copies then move them as whole registers and the
+	//	vector loads that follow are forwarded from the stores
+	double	myD[N];
+	double	myV;
+};
@@ -10,18 +10,66 @@
 //
 //		[1-theta dt A] V(t) = [1 + (1-theta) dt A] V(t+dt)
 //
+//	by default the operators are assembled into n x 3 matrices, and the
+//	implicit one is factored, once per change of coefficients or step. in
+//	fused mode the operator rows are computed on the fly inside the band
+//	multiplication and the thomas sweeps instead, saving the round trip of
+//	the matrices through memory. fused pays off when the coefficients change
+//	every step, with constant coefficients the cached factorization is cheaper.
+//	fused mode always uses the current coefficients, the update flag is ignored
+//
+//	on uniform grids (G = kGridUniform) the stencils are stored for the first,
+//	interior and last node only. if in addition r, mu and var are constant
+//	across the nodes, the operators collapse to a few rows: all interior rows
+//	coincide, the explicit step becomes a flat 3 point stencil over the
+//	results and the implicit sweeps read hardly more than the results
+//
+//	with setParallel the implicit systems of grids of at least minSize nodes
+//	are factored and solved with kParallelTridag on the threads of a pool.
+//	do not use it from tasks running on the same pool
+//
+//	rollBwd takes an optional obstacle for american exercise: the implicit
+//	solve then solves the complementarity problem V(t) >= obstacle instead of
+//	projecting after the step, by brennan-schwartz (exact for an exercise
+//	region at one end of the grid, taken per slot from the end where the
+//	obstacle is larger) or by penalty iteration. the projected solves run
+//	on the full operator, serially and one slot at a time
+//
+//	rollBwdAdjoint rolls back over many steps and differentiates a linear
+//	functional of the results at 0 to r, mu and var at every node and to the
+//	terminal results, in reverse mode: the adjoint steps transpose the
+//	explicit operator and solve with the transpose of the factored implicit
+//	one, accumulating the derivative to the operator entries on the way.
+//	slices of the roll are checkpointed every c steps and the steps between
+//	two checkpoints recomputed, so the cost is about two rolls and an adjoint
+//	roll in memory of about 2 sqrt(numSteps) slices for the default c. no
+//	obstacle, american exercise is not differentiable this way
+//
+//	rollBwdExplicit takes many explicit (theta = 0) steps at once, time
+//	skewed for grids beyond the caches: the grid is cut into tiles that
+//	advance a block of steps while resident. every tile reads its nodes
+//	plus a halo of one node per step on either side, computes a shrinking
+//	trapezoid of time levels in a thread local buffer and writes its own
+//	nodes only, so the results go through memory once per block instead of
+//	once per step. the halos are computed twice, a fraction of about
+//	block / tile. tiles run on the threads of a pool if parallel. results
+//	agree with rollBwd at theta = 0 to the last bit
+//
 
 //	includes
 #include "kFiniteDifference.h"
 #include "kMatrixAlgebra.h"
+#include "kParallelTridag.h"
+#include "kSlotMatrix.h"
 
-//	class declaration
-template <class V>
+//	class declaration, G = kGridUniform for uniform grids
+template <class V, class G = kGridGeneral>
 class kFd1d
 {
 public:
 
-	//	init 
+	//	init, storage is kept: re-init for a grid of equal or smaller size
+	//	with the same numV does not touch the heap
 	void	init(
 		int						numV,
 		const kVector<V>&		x,
@@ -31,13 +79,32 @@ public:
 	const kVector<V>&			mu()	const { return myMu; }
 	const kVector<V>&			var()	const { return myVar; }
 	const kVector<V>&			x()		const { return myX; }
-	const kVector<kVector<V>>&	res()	const { return myRes; }
+	const kSlotMatrix<V>&		res()	const { return myRes; }
 
 	kVector<V>&					r()		{ return myR; }
 	kVector<V>&					mu()	{ return myMu; }
 	kVector<V>&					var()	{ return myVar; }
 	kVector<V>&					x()		{ return myX; }
-	kVector<kVector<V>>&		res()	{ return myRes; }
+	kSlotMatrix<V>&				res()	{ return myRes; }
+
+	//	x is log(s)
+	bool						isLog()	const { return myLog; }
+
+	//	fused mode
+	bool						fused()	const { return myFused; }
+	void						setFused(bool fused) { myFused = fused; }
+
+	//	threaded implicit solves on grids of at least minSize nodes, null pool for the shared one
+	void						setParallel(
+		bool					on,
+		kThreadPool*			pool	= nullptr,
+		int						minSize	= kParallelTridag<V>::defaultMinSize)
+	{
+		myParOn = on;
+		myPar.setPool(pool);
+		myPar.setMinSize(minSize);
+		myThetac = -1.0;
+	}
 
 	//	operator
 	void	calcAx(
@@ -47,7 +114,24 @@ public:
 		bool					tr,
 		kMatrix<V>&				A) const;
 
-	//	roll bwd
+	//	american exercise methods
+	enum Exercise
+	{
+		brennanSchwartz,
+		penalty
+	};
+
+	//	roll bwd, obstacle (any layout, same dims as res) enforced in the implicit solve if given
+	void	rollBwd(
+		V						dt,
+		bool					update,
+		V						theta,
+		int						wind,
+		kSlotMatrix<V>&			res,
+		const kSlotMatrix<V>*	obstacle = nullptr,
+		Exercise				exercise = brennanSchwartz);
+
+	//	roll bwd, vector of vectors results
 	void	rollBwd(
 		V						dt,
 		bool					update,
@@ -56,6 +140,14 @@ public:
 		kVector<kVector<V>>&	res);
 
 	//	roll fwd
+	void	rollFwd(
+		V						dt,
+		bool					update,
+		V						theta,
+		int						wind,
+		kSlotMatrix<V>&			res);
+
+	//	roll fwd, vector of vectors results
 	void	rollFwd(
 		V						dt,
 		bool					update,
@@ -63,35 +155,232 @@ public:
 		int						wind,
 		kVector<kVector<V>>&	res);
 
+	//	numSteps explicit steps bwd, time skewed, obstacle projected after every step if given,
+	//	tile nodes and block steps per block, 0 for automatic, null pool for the shared one
+	void	rollBwdExplicit(
+		V						dt,
+		int						numSteps,
+		int						wind,
+		kSlotMatrix<V>&			res,
+		const kSlotMatrix<V>*	obstacle	= nullptr,
+		int						tile		= 0,
+		int						block		= 0,
+		bool					parallel	= false,
+		kThreadPool*			pool		= nullptr);
+
+	//	numSteps rollBwd steps of dt and the adjoint of P = sum w(k,i) res(k,i) at 0:
+	//	res holds the terminal results on entry and the results at 0 on exit,
+	//	dr, dmu, dvar the derivatives of P to the coefficients of every node
+	//	(summed over the slots), dres to the terminal results. checkpoints every
+	//	numCheck steps, 0 for sqrt(numSteps)
+	void	rollBwdAdjoint(
+		V						dt,
+		int						numSteps,
+		V						theta,
+		int						wind,
+		kSlotMatrix<V>&			res,
+		const kSlotMatrix<V>&	w,
+		kVector<V>&				dr,
+		kVector<V>&				dmu,
+		kVector<V>&				dvar,
+		kSlotMatrix<V>&			dres,
+		int						numCheck = 0);
+
+	//	greeks of slot k of res on the grid into n x 3: first and second derivative
+	//	from the central stencils, in x also on log grids, the end nodes take the
+	//	second derivative of their neighbour, and theta from the results one
+	//	(prev1) and two (prev2) steps of dt earlier in the roll: one sided 3 point,
+	//	(prev1 - res) / dt without prev2, 0 without either
+	void	greeks(
+		int						k,
+		const kVector<V>*		prev1,
+		const kVector<V>*		prev2,
+		V						dt,
+		kMatrix<V>&				out) const;
+
+	//	factorizations of the implicit operator since construction
+	long long	numFactor() const { return myNumFactor; }
+
+	//	penalty solves since construction
+	long long	numPenalty() const { return myNumPenalty; }
+
+	//	operator state changed since last build
+	bool	isDirty(
+		V						dt,
+		V						theta,
+		int						wind,
+		bool					tr);
+
 private:
 
+	//	build explicit or implicit operator, compact if myConst
+	void	buildOp(
+		V						one,
+		V						dtTheta,
+		int						wind,
+		bool					tr,
+		bool					impl);
+
+	//	explicit step X = Ae B
+	void	applyOp(
+		const kMatrixView<V>	B,
+		kMatrixView<V>			X) const;
+
+	//	implicit step Ai U = R
+	void	solveOp(
+		const kMatrixView<V>	R,
+		kMatrixView<V>			U);
+
+	//	implicit step Ai U = R subject to U >= obstacle
+	void	solveObstacle(
+		V						dtTheta,
+		int						wind,
+		const kMatrixView<V>	R,
+		kMatrixView<V>			U,
+		const kSlotMatrix<V>&	obstacle,
+		Exercise				exercise);
+
+	//	full implicit operator for the obstacle and adjoint solves, buildOp's unless compact or threaded
+	const kMatrix<V>&	fullOp(
+		V						dtTheta,
+		int						wind);
+
+	//	threaded implicit solves
+	bool	parallel() const { return myParOn && myPar.threaded(myX.size()); }
+
+	//	compact operator: rows of nodes 0, 1, interior, n-2 and n-1
+	void	calcAc(
+		V						one,
+		V						dtTheta,
+		int						wind,
+		bool					tr,
+		kMatrix<V>&				C) const;
+
+	//	operator row i of [one + dtTheta A]
+	void	calcRow(
+		int						i,
+		V						one,
+		V						dtTheta,
+		int						wind,
+		V*						a) const;
+
+	//	fused explicit step R = [one + dtTheta A] R, tr for the transpose
+	void	fusedExplicit(
+		V						one,
+		V						dtTheta,
+		int						wind,
+		bool					tr,
+		kMatrixView<V>			R);
+
+	//	fused implicit step [one + dtTheta A] U = R, in place
+	void	fusedImplicit(
+		V						one,
+		V						dtTheta,
+		int						wind,
+		bool					tr,
+		kMatrixView<V>			R);
+
+	//	explicit operator row i
+	const V*	rowOp(int i) const
+	{
+		if(!myConst)	return &myAe(i,0);
+		int n = myX.size();
+		return &myAec(i<2 ? i : i<n-2 ? 2 : i-n+5, 0);
+	}
+
+	//	explicit step of nodes [l, h), rows of B from node bl, rows of X from node xl
+	void	applyRange(
+		int						l,
+		int						h,
+		const V*				B,
+		int						bl,
+		V*						X,
+		int						xl,
+		int						numV,
+		const kSlotMatrix<V>*	obstacle) const;
+
 	//	r, mu, var
 	kVector<V>	myX, myR, myMu, myVar;
 
+	//	log transform, dxx stencil holds dxx - dx
+	bool		myLog{false};
+
 	//	diff operators
-	kMatrix<V>	myDxd, myDxu, myDx, myDxx;
+	kStencil<V,G>	myDxd, myDxu, myDx, myDxx;
 
 	//	operator matrix
 	kMatrix<V>	myAe, myAi;
 
-	//	helper
-	kVector<V>	myVs, myWs;
+	//	factorization of implicit operator
+	kVector<V>	myBeti, myGam;
+
+	//	operator cache: r, mu, var, dt, theta, wind and transpose the operators were built for
+	kVector<V>	myRc, myMuc, myVarc;
+	V			myDtc, myThetac;
+	int			myWindc;
+	bool		myTrc;
+
+	//	uniform grid, constant coefficients: compact operators and start of the stationary part of the factorization
+	bool		myConst{false};
+	kMatrix<V>	myAec, myAic;
+	int			myStat{0};
+
+	//	factorization counter
+	long long	myNumFactor{0};
 
-	//	vector of results
-	kVector<kVector<V>> myRes;
+	//	threaded implicit solves
+	bool				myParOn{false};
+	kParallelTridag<V>	myPar;
+
+	//	american exercise: full implicit operator when buildOp keeps a compact or
+	//	threaded one, its LU and UL factorizations and per slot workspace
+	bool			myObsDirty{true}, myObsLU{false}, myObsUL{false};
+	kMatrix<V>		myAo;
+	kVector<V>		myBetio, myGamo, myBetiu, myGamu;
+	kVector<V>		myOr, myOg, myOu, myOd, myOw;
+	long long		myNumPenalty{0};
+
+	//	fused mode and its sweep storage
+	bool			myFused{false};
+	kVector<V>		myGamf;
+	kMatrix<V>		myRows;
+
+	//	helpers
+	kMatrix<V>		myVm;
+	kSlotMatrix<V>	myTmp;
+
+	//	time skewing: two time level buffers per thread
+	kVector<kMatrix<V>>	mySkew;
+
+	//	adjoint: checkpoints, slices between two, adjoint results and operator derivatives
+	kVector<kMatrix<V>>	myChk, mySeg;
+	kMatrix<V>			myLam, myLamI, myDA;
+
+	//	results
+	kSlotMatrix<V>	myRes;
 };
 
 //	init
-template <class V>
+template <class V, class G>
 void
-kFd1d<V>::init(
+kFd1d<V,G>::init(
 	int					numV,
 	const kVector<V>&	x,
 	bool				log)
 {
 	myX = x;
-	myRes.resize(numV);
-	for(int k=0;k<numV;++k) myRes[k].resize(myX.size());
+	myLog = log;
+	myRes.resize(numV, myX.size());
+
+	//	invalidate operator cache
+	myRc.clear();
+	myMuc.clear();
+	myVarc.clear();
+	myDtc	 = 0.0;
+	myThetac = -1.0;
+	myWindc	 = 0;
+	myTrc	 = false;
+	myConst	 = false;
 
 	//	resize params
 	myR.resize(myX.size(), 0.0);
@@ -107,30 +396,33 @@ kFd1d<V>::init(
 
 	int numC = myDx.cols();
 
-	//	log transform case
+	//	log transform case, on the stored interior rows
 	if(log)
 	{
-		int n = myX.size()-1;
+		int n = myDxx.data().rows()-1;
 		for(int i = 1;i<n;++i)
 		{
 			for(int j=0;j<numC;++j)
-				myDxx(i,j) -= myDx(i,j);
+				myDxx.data()(i,j) -= myDx.data()(i,j);
 		}
 	}
 
 	myAe.resize(myX.size(),numC);
 	myAi.resize(myX.size(),numC);
-	myVs.resize(myX.size());
-	myWs.resize(myX.size());
+	myBeti.resize(myX.size());
+	myGam.resize(myX.size());
+	myGamf.resize(myX.size());
+	myVm.resize(myX.size(),numV);
+	myRows.resize(2,numV);
 
 	//	done
 	return;
 }
 
 //	construct operator
-template <class V>
+template <class V, class G>
 void
-kFd1d<V>::calcAx(
+kFd1d<V,G>::calcAx(
 	V				one,
 	V				dtTheta,
 	int				wind,
@@ -149,7 +441,7 @@ kFd1d<V>::calcAx(
 	int i, j;
 
 	//	wind
-	const kMatrix<V>*	Dx = 0;
+	const kStencil<V,G>*	Dx = 0;
 	if(wind<0)			Dx = &myDxd;
 	else if(wind==0)	Dx = &myDx;
 	else if(wind==1)	Dx = &myDxu;
@@ -175,42 +467,75 @@ kFd1d<V>::calcAx(
 }
 
 //	roll bwd
-template <class V>
+template <class V, class G>
 void
-kFd1d<V>::rollBwd(
+kFd1d<V,G>::rollBwd(
 	V						dt,
 	bool					update,
 	V						theta,
 	int						wind,
-	kVector<kVector<V>>&	res)
+	kSlotMatrix<V>&			res,
+	const kSlotMatrix<V>*	obstacle,
+	Exercise				exercise)
 {
+	//	slot major results are rolled in node major work storage
+	if(res.layout()!=kSlotMatrix<V>::nodeMajor)
+	{
+		myTmp.resize(res.numV(), res.numX());
+		res.copyTo(myTmp);
+		rollBwd(dt, update, theta, wind, myTmp, obstacle, exercise);
+		myTmp.copyTo(res);
+		return;
+	}
+
 	//	helps
-	int k;
+	int i, k;
 
 	//	dims
-	int n = myX.size();
-	int mm = 1;
-	int numV = (int)res.size();
+	kMatrixView<V> R = res();
 
-	//	explicit
+	//	fused, not with an obstacle
+	if(myFused && !obstacle)
+	{
+		if(theta!=1.0) fusedExplicit(1.0, dt*(1.0-theta), wind, false, R);
+		if(theta!=0.0) fusedImplicit(1.0, -dt*theta, wind, false, R);
+		return;
+	}
+
+	//	only rebuild operators if something changed
+	if(update) update = isDirty(dt, theta, wind, false);
+
+	//	explicit, into helper if implicit follows
 	if(theta!=1.0)
 	{
-		if(update) calcAx(1.0, dt*(1.0-theta), wind, false, myAe);
-		for (k = 0; k < numV; ++k)
+		if(update) buildOp(1.0, dt*(1.0-theta), wind, false, false);
+		myVm.resize(R.rows(), R.cols());
+		if(theta!=0.0)
+		{
+			applyOp(R, myVm());
+		}
+		else
 		{
-			myVs = res[k];
-			kMatrixAlgebra::banmul(myAe, mm, mm, myVs, res[k]);
+			for(i=0;i<R.size();++i) myVm[i] = R[i];
+			applyOp(myVm(), R);
 		}
 	}
 
 	//	implicit
 	if(theta!=0.0)
 	{
-		if(update) calcAx(1.0, -dt*theta, wind, false, myAi);
-		for (k = 0; k < numV; ++k)
+		if(update) buildOp(1.0, -dt*theta, wind, false, true);
+		const kMatrixView<V> S = theta!=1.0 ? myVm() : R;
+		if(obstacle)	solveObstacle(-dt*theta, wind, S, R, *obstacle, exercise);
+		else			solveOp(S, R);
+	}
+
+	//	explicit with an obstacle: project
+	else if(obstacle)
+	{
+		for(k=0;k<res.numV();++k)
 		{
-			myVs = res[k];
-			kMatrixAlgebra::tridag(myAi, myVs, res[k], myWs);
+			for(i=0;i<res.numX();++i) res(k,i) = max(res(k,i), (*obstacle)(k,i));
 		}
 	}
 
@@ -218,45 +543,973 @@ kFd1d<V>::rollBwd(
 	return;
 }
 
-//	roll fwd
-template <class V>
+//	roll bwd, vector of vectors results
+template <class V, class G>
 void
-kFd1d<V>::rollFwd(
+kFd1d<V,G>::rollBwd(
 	V						dt,
 	bool					update,
 	V						theta,
 	int						wind,
 	kVector<kVector<V>>&	res)
 {
+	myTmp.setSlots(res);
+	rollBwd(dt, update, theta, wind, myTmp);
+	myTmp.getSlots(res);
+
+	//	done
+	return;
+}
+
+//	time skewed explicit steps
+template <class V, class G>
+void
+kFd1d<V,G>::rollBwdExplicit(
+	V						dt,
+	int						numSteps,
+	int						wind,
+	kSlotMatrix<V>&			res,
+	const kSlotMatrix<V>*	obstacle,
+	int						tile,
+	int						block,
+	bool					parallel,
+	kThreadPool*			pool)
+{
+	//	slot major results are rolled in node major work storage
+	if(res.layout()!=kSlotMatrix<V>::nodeMajor)
+	{
+		myTmp.resize(res.numV(), res.numX());
+		res.copyTo(myTmp);
+		rollBwdExplicit(dt, numSteps, wind, myTmp, obstacle, tile, block, parallel, pool);
+		myTmp.copyTo(res);
+		return;
+	}
+
+	//	dims
+	kMatrixView<V> R = res();
+	int n	 = R.rows();
+	int numV = R.cols();
+	if(n<2 || numSteps<=0) return;
+
+	//	operator
+	if(isDirty(dt, 0.0, wind, false)) buildOp(1.0, dt, wind, false, false);
+
+	//	threads
+	kThreadPool& tp = pool ? *pool : kThreadPool::global();
+	int numT = parallel ? tp.numThreads() : 1;
+
+	//	sizes: two time levels of a tile with halos in about 256k, tiles for all threads
+	if(block<=0) block = 16;
+	block = min(block, numSteps);
+	if(tile<=0)
+	{
+		tile = max(64, (1<<15)/numV - 2*block);
+		if(numT>1) tile = max(64, min(tile, n/(4*numT)));
+	}
+	tile = min(tile, n);
+	int numTiles = (n + tile - 1)/tile;
+
+	//	buffers
+	myVm.resize(n, numV);
+	mySkew.resize(2*numT);
+	for(int t=0;t<2*numT;++t) mySkew(t).resize(tile + 2*block, numV);
+
+	//	blocks, alternating between res and the helper
+	V* src = &R(0,0);
+	V* dst = &myVm(0,0);
+	for(int done=0;done<numSteps;done+=block)
+	{
+		int s = min(block, numSteps - done);
+
+		auto task = [&](int p, int t)
+		{
+			//	own nodes and halo
+			int a  = p*tile, b = min(n, a + tile);
+			int lo = max(0, a - s), hi = min(n, b + s);
+
+			//	step k computes [l, h) into the other level, the last one into dst
+			V* buf[2] = { &mySkew(2*t)(0,0), &mySkew(2*t+1)(0,0) };
+			const V* in = src;
+			int inl = 0;
+			int l = lo, h = hi;
+			for(int k=1;k<=s;++k)
+			{
+				if(lo>0) ++l;
+				if(hi<n) --h;
+				if(k<s)
+				{
+					applyRange(l, h, in, inl, buf[k&1], lo, numV, obstacle);
+					in	= buf[k&1];
+					inl	= lo;
+				}
+				else
+				{
+					applyRange(a, b, in, inl, dst, 0, numV, obstacle);
+				}
+			}
+		};
+
+		if(numT>1)	tp.parallelFor(numTiles, task);
+		else		for(int p=0;p<numTiles;++p) task(p, 0);
+
+		kInlines::swap(src, dst);
+	}
+
+	//	result in the helper
+	if(src!=&R(0,0))
+	{
+		for(int i=0;i<R.size();++i) R[i] = myVm[i];
+	}
+
+	//	done
+	return;
+}
+
+//	explicit step of a range of nodes
+template <class V, class G>
+void
+kFd1d<V,G>::applyRange(
+	int						l,
+	int						h,
+	const V*				B,
+	int						bl,
+	V*						X,
+	int						xl,
+	int						numV,
+	const kSlotMatrix<V>*	obstacle) const
+{
+	//	dims
+	int n = myX.size();
+
+	//	helps
+	int i, k;
+	V a0, a1, a2;
+	const V* a;
+
+	//	first and last node
+	if(l==0)
+	{
+		a = rowOp(0);
+		a1 = a[1];
+		a2 = a[2];
+		for(k=0;k<numV;++k) X[k-xl*numV] = a1*B[k-bl*numV] + a2*B[k+(1-bl)*numV];
+	}
+	if(h==n)
+	{
+		a = rowOp(n-1);
+		a0 = a[0];
+		a1 = a[1];
+		const V* bi = B + (n-1-bl)*numV;
+		V* xi		= X + (n-1-xl)*numV;
+		for(k=0;k<numV;++k) xi[k] = a0*bi[k-numV] + a1*bi[k];
+	}
+
+	//	interior, compact operators share one row
+	int il = max(l, 1), iu = min(h, n-1);
+	const V* b = B - bl*numV;
+	V* x	   = X - xl*numV;
+	if(myConst)
+	{
+		a  = rowOp(1);
+		a0 = a[0];
+		a1 = a[1];
+		a2 = a[2];
+		int kl = il*numV, ku = iu*numV;
+		for(k=kl;k<ku;++k) x[k] = a0*b[k-numV] + a1*b[k] + a2*b[k+numV];
+	}
+	else if(numV==1)
+	{
+		for(i=il;i<iu;++i)
+		{
+			a = &myAe(i,0);
+			x[i] = a[0]*b[i-1] + a[1]*b[i] + a[2]*b[i+1];
+		}
+	}
+	else
+	{
+		for(i=il;i<iu;++i)
+		{
+			a  = &myAe(i,0);
+			a0 = a[0];
+			a1 = a[1];
+			a2 = a[2];
+			const V* bi = b + i*numV;
+			V* xi		= x + i*numV;
+			for(k=0;k<numV;++k) xi[k] = a0*bi[k-numV] + a1*bi[k] + a2*bi[k+numV];
+		}
+	}
+
+	//	project
+	if(obstacle)
+	{
+		for(i=l;i<h;++i)
+		{
+			V* xi = x + i*numV;
+			for(k=0;k<numV;++k) xi[k] = max(xi[k], (*obstacle)(k,i));
+		}
+	}
+
+	//	done
+	return;
+}
+
+//	roll bwd with adjoint
+template <class V, class G>
+void
+kFd1d<V,G>::rollBwdAdjoint(
+	V						dt,
+	int						numSteps,
+	V						theta,
+	int						wind,
+	kSlotMatrix<V>&			res,
+	const kSlotMatrix<V>&	w,
+	kVector<V>&				dr,
+	kVector<V>&				dmu,
+	kVector<V>&				dvar,
+	kSlotMatrix<V>&			dres,
+	int						numCheck)
+{
+	//	slot major results are rolled in node major work storage
+	if(res.layout()!=kSlotMatrix<V>::nodeMajor)
+	{
+		myTmp.resize(res.numV(), res.numX());
+		res.copyTo(myTmp);
+		rollBwdAdjoint(dt, numSteps, theta, wind, myTmp, w, dr, dmu, dvar, dres, numCheck);
+		myTmp.copyTo(res);
+		return;
+	}
+
 	//	helps
-	int k;
+	int i, j, k, l, m, q;
 
 	//	dims
-	int n    = myX.size();
-	int mm   = myDx.cols()/2;
-	int numV = (int)res.size();
+	int n	 = myX.size();
+	int numV = res.numV();
+	int N	 = max(0, numSteps);
+	int c	 = numCheck>0 ? numCheck : max(1, (int)ceil(sqrt((double)N)));
+	int numC = N/c + 1;
+	kMatrixView<V> R = res();
 
-	//	implicit
+	//	roll, checkpoint q holds the results after N - m = q c steps
+	myChk.resize(numC);
+	for(m=N;m>=0;--m)
+	{
+		if((N-m)%c==0)
+		{
+			kMatrix<V>& C = myChk((N-m)/c);
+			C.resize(n, numV);
+			for(i=0;i<R.size();++i) C[i] = R[i];
+		}
+		if(m>0) rollBwd(dt, true, theta, wind, res);
+	}
+
+	//	operators, normally left by the roll
+	if(isDirty(dt, theta, wind, false))
+	{
+		if(theta!=1.0) buildOp(1.0, dt*(1.0-theta), wind, false, false);
+		if(theta!=0.0) buildOp(1.0, -dt*theta, wind, false, true);
+	}
+
+	//	full implicit operator and its factors
+	const kMatrix<V>* Ai = nullptr;
+	const kVector<V>* beti = nullptr;
+	const kVector<V>* gam = nullptr;
 	if(theta!=0.0)
 	{
-		if(update) calcAx(1.0,-dt*theta,wind,true,myAi);
-		for(k=0;k<numV;++k)
+		bool own = myConst || parallel();
+		Ai = &fullOp(-dt*theta, wind);
+		if(own && !myObsLU)
+		{
+			kMatrixAlgebra::tridagFactor(*Ai, myBetio, myGamo);
+			myObsLU = true;
+		}
+		beti = own ? &myBetio : &myBeti;
+		gam  = own ? &myGamo  : &myGam;
+	}
+
+	//	adjoint of the results at 0
+	myLam.resize(n, numV);
+	myLamI.resize(n, numV);
+	for(i=0;i<n;++i)
+	{
+		for(k=0;k<numV;++k) myLam(i,k) = w(k,i);
+	}
+
+	//	derivatives to the operator entries
+	myDA.resize(n, 3);
+	for(i=0;i<myDA.size();++i) myDA[i] = 0.0;
+
+	//	segments between checkpoints, from the results at 0
+	mySeg.resize(c+1);
+	myVm.resize(n, numV);
+	for(q=numC-1;q>=0;--q)
+	{
+		int T = N - q*c;
+		int B = max(0, T - c);
+		if(T==0) continue;
+
+		//	slices B..T
+		mySeg(T-B).resize(n, numV);
+		for(i=0;i<myChk(q).size();++i) mySeg(T-B)[i] = myChk(q)[i];
+		for(m=T-1;m>=B;--m)
+		{
+			const kMatrixView<V> S = mySeg(m-B+1)();
+			mySeg(m-B).resize(n, numV);
+			kMatrixView<V> D = mySeg(m-B)();
+			if(theta!=1.0 && theta!=0.0)
+			{
+				applyOp(S, myVm());
+				solveOp(myVm(), D);
+			}
+			else if(theta!=1.0)
+			{
+				applyOp(S, D);
+			}
+			else
+			{
+				solveOp(S, D);
+			}
+		}
+
+		//	adjoint steps from slice m + 1 to m
+		for(m=B;m<T;++m)
+		{
+			const kMatrix<V>& V0 = mySeg(m-B);
+			const kMatrix<V>& V1 = mySeg(m-B+1);
+
+			//	implicit: Ai^T lamI = lam
+			if(theta!=0.0)	kMatrixAlgebra::tridagSolveTransposedMulti((*Ai)(), (*beti)(), (*gam)(), myLam(), myLamI());
+			else			for(i=0;i<myLam.size();++i) myLamI[i] = myLam[i];
+
+			//	operator entries: dt lamI(i) (theta V0 + (1 - theta) V1)(i+j-1)
+			for(i=0;i<n;++i)
+			{
+				const V* li = &myLamI(i,0);
+				for(j=0;j<3;++j)
+				{
+					l = i + j - 1;
+					if(l<0 || l>=n) continue;
+					const V* v0 = &V0(l,0);
+					const V* v1 = &V1(l,0);
+					V s = 0.0;
+					for(k=0;k<numV;++k) s += li[k] * (theta*v0[k] + (1.0-theta)*v1[k]);
+					myDA(i,j) += dt*s;
+				}
+			}
+
+			//	explicit: lam = Ae^T lamI
+			if(theta!=1.0)
+			{
+				for(i=0;i<n;++i)
+				{
+					V* li = &myLam(i,0);
+					const V* a = rowOp(i);
+					for(k=0;k<numV;++k) li[k] = a[1]*myLamI(i,k);
+					if(i>0)
+					{
+						a = rowOp(i-1);
+						for(k=0;k<numV;++k) li[k] += a[2]*myLamI(i-1,k);
+					}
+					if(i<n-1)
+					{
+						a = rowOp(i+1);
+						for(k=0;k<numV;++k) li[k] += a[0]*myLamI(i+1,k);
+					}
+				}
+			}
+			else
+			{
+				for(i=0;i<myLam.size();++i) myLam[i] = myLamI[i];
+			}
+		}
+	}
+
+	//	terminal results
+	dres.resize(numV, n);
+	for(k=0;k<numV;++k)
+	{
+		for(i=0;i<n;++i) dres(k,i) = myLam(i,k);
+	}
+
+	//	coefficients: A(i,j) = mu Dx(i,j) + var/2 Dxx(i,j) - r on the diagonal
+	dr.resize(n);
+	dmu.resize(n);
+	dvar.resize(n);
+	const kStencil<V,G>* Dx = wind<0 ? &myDxd : wind==0 ? &myDx : &myDxu;
+	for(i=0;i<n;++i)
+	{
+		if(wind>1) Dx = myMu(i)<0.0 ? &myDxd : &myDxu;
+		dr(i) = -myDA(i,1);
+		dmu(i) = dvar(i) = 0.0;
+		for(j=0;j<3;++j)
 		{
-			myVs = res[k];
-			kMatrixAlgebra::tridag(myAi,myVs,res[k],myWs);
+			dmu(i)	+= (*Dx)(i,j) * myDA(i,j);
+			dvar(i) += 0.5 * myDxx(i,j) * myDA(i,j);
 		}
 	}
 
+	//	done
+	return;
+}
+
+//	greeks on the grid
+template <class V, class G>
+void
+kFd1d<V,G>::greeks(
+	int						k,
+	const kVector<V>*		prev1,
+	const kVector<V>*		prev2,
+	V						dt,
+	kMatrix<V>&				out) const
+{
+	//	dims
+	int n = myX.size();
+	out.resize(n, 3);
+	if(!n) return;
+
+	//	helps
+	int i, j, l;
+	V v, d, dd;
+
+	//	derivatives
+	for(i=0;i<n;++i)
+	{
+		d = dd = 0.0;
+		for(j=0;j<3;++j)
+		{
+			l = i + j - 1;
+			if(l<0 || l>=n) continue;
+			v	= myRes(k,l);
+			d  += myDx(i,j) * v;
+			dd += myDxx(i,j) * v;
+		}
+		out(i,0) = d;
+		out(i,1) = myLog ? dd + d : dd;
+	}
+	if(n>2)
+	{
+		out(0,1)   = out(1,1);
+		out(n-1,1) = out(n-2,1);
+	}
+
+	//	theta
+	for(i=0;i<n;++i)
+	{
+		v = myRes(k,i);
+		if(!prev1 || !(dt>0.0))	out(i,2) = 0.0;
+		else if(!prev2)			out(i,2) = ((*prev1)(i) - v) / dt;
+		else					out(i,2) = (4.0*(*prev1)(i) - (*prev2)(i) - 3.0*v) / (2.0*dt);
+	}
+
+	//	done
+	return;
+}
+
+//	roll fwd
+template <class V, class G>
+void
+kFd1d<V,G>::rollFwd(
+	V						dt,
+	bool					update,
+	V						theta,
+	int						wind,
+	kSlotMatrix<V>&			res)
+{
+	//	slot major results are rolled in node major work storage
+	if(res.layout()!=kSlotMatrix<V>::nodeMajor)
+	{
+		myTmp.resize(res.numV(), res.numX());
+		res.copyTo(myTmp);
+		rollFwd(dt, update, theta, wind, myTmp);
+		myTmp.copyTo(res);
+		return;
+	}
+
+	//	helps
+	int i;
+
+	//	dims
+	kMatrixView<V> R = res();
+
+	//	fused
+	if(myFused)
+	{
+		if(theta!=0.0) fusedImplicit(1.0, -dt*theta, wind, true, R);
+		if(theta!=1.0) fusedExplicit(1.0, dt*(1.0-theta), wind, true, R);
+		return;
+	}
+
+	//	only rebuild operators if something changed
+	if(update) update = isDirty(dt, theta, wind, true);
+
+	//	implicit, into helper if explicit follows
+	myVm.resize(R.rows(), R.cols());
+	if(theta!=0.0)
+	{
+		if(update) buildOp(1.0,-dt*theta,wind,true,true);
+		if(theta!=1.0)	solveOp(R,myVm());
+		else			solveOp(R,R);
+	}
+
 	//	explicit
 	if(theta!=1.0)
 	{
-		if(update) calcAx(1.0,dt*(1.0-theta),wind,true,myAe);
-		for(k=0;k<numV;++k)
+		if(update) buildOp(1.0,dt*(1.0-theta),wind,true,false);
+		if(theta==0.0)
+		{
+			for(i=0;i<R.size();++i) myVm[i] = R[i];
+		}
+		applyOp(myVm(),R);
+	}
+
+	//	done
+	return;
+}
+
+//	roll fwd, vector of vectors results
+template <class V, class G>
+void
+kFd1d<V,G>::rollFwd(
+	V						dt,
+	bool					update,
+	V						theta,
+	int						wind,
+	kVector<kVector<V>>&	res)
+{
+	myTmp.setSlots(res);
+	rollFwd(dt, update, theta, wind, myTmp);
+	myTmp.getSlots(res);
+
+	//	done
+	return;
+}
+
+//	operator state changed since last build
+template <class V, class G>
+bool
+kFd1d<V,G>::isDirty(
+	V				dt,
+	V				theta,
+	int				wind,
+	bool			tr)
+{
+	//	dims
+	int n = myX.size();
+
+	//	step and scheme
+	bool dirty = dt!=myDtc || theta!=myThetac || wind!=myWindc || tr!=myTrc || myRc.size()!=n;
+
+	//	coefficients
+	for(int i=0;!dirty && i<n;++i)
+	{
+		dirty = myR(i)!=myRc(i) || myMu(i)!=myMuc(i) || myVar(i)!=myVarc(i);
+	}
+
+	//	record new state
+	if(dirty)
+	{
+		if constexpr(kStencil<V,G>::uniform)
+		{
+			myConst = n>=5;
+			for(int i=1;myConst && i<n;++i)
+			{
+				myConst = myR(i)==myR(0) && myMu(i)==myMu(0) && myVar(i)==myVar(0);
+			}
+		}
+		myRc	 = myR;
+		myMuc	 = myMu;
+		myVarc	 = myVar;
+		myDtc	 = dt;
+		myThetac = theta;
+		myWindc	 = wind;
+		myTrc	 = tr;
+	}
+
+	//	done
+	return dirty;
+}
+
+//	operator row
+template <class V, class G>
+void
+kFd1d<V,G>::calcRow(
+	int				i,
+	V				one,
+	V				dtTheta,
+	int				wind,
+	V*				a) const
+{
+	//	wind
+	const kStencil<V,G>*	Dx = &myDx;
+	if(wind<0)			Dx = &myDxd;
+	else if(wind==1)	Dx = &myDxu;
+	else if(wind>1)		Dx = myMu(i)<0.0 ? &myDxd : &myDxu;
+
+	//	same arithmetic as calcAx
+	const V	 mu	 = myMu(i);
+	const V	 var = myVar(i);
+	const V* dx	 = &(*Dx)(i,0);
+	const V* dxx = &myDxx(i,0);
+	a[0] = dtTheta * (mu*dx[0] + 0.5*var*dxx[0]);
+	a[1] = dtTheta * (mu*dx[1] + 0.5*var*dxx[1]);
+	a[2] = dtTheta * (mu*dx[2] + 0.5*var*dxx[2]);
+	a[1] += one - dtTheta*myR(i);
+
+	//	done
+	return;
+}
+
+//	fused explicit step
+template <class V, class G>
+void
+kFd1d<V,G>::fusedExplicit(
+	V				one,
+	V				dtTheta,
+	int				wind,
+	bool			tr,
+	kMatrixView<V>	R)
+{
+	//	dims
+	int n	 = myX.size();
+	int numV = R.cols();
+	if(!n) return;
+
+	//	helps
+	int i, h;
+	V	al[3], a[3], au[3], b[3];
+
+	//	old values of rows i-1 and i, the update is in place
+	myRows.resize(2, numV);
+	V* prev = &myRows(0,0);
+	V* cur	= &myRows(1,0);
+
+	//	rows i and i+1 of the operator
+	calcRow(0, one, dtTheta, wind, a);
+	if(n>1) calcRow(1, one, dtTheta, wind, au);
+
+	for(i=0;i<n;++i)
+	{
+		//	row i of the operator or its transpose
+		if(tr)
+		{
+			b[0] = i>0 ? al[2] : V(0.0);
+			b[1] = a[1];
+			b[2] = i<n-1 ? au[0] : V(0.0);
+		}
+		else
+		{
+			b[0] = a[0];
+			b[1] = a[1];
+			b[2] = a[2];
+		}
+
+		//	multiply
+		V* ri = &R(i,0);
+		for(h=0;h<numV;++h) cur[h] = ri[h];
+		if(i>0 && i<n-1)
+		{
+			const V* ru = &R(i+1,0);
+			for(h=0;h<numV;++h) ri[h] = b[0]*prev[h] + b[1]*cur[h] + b[2]*ru[h];
+		}
+		else if(i<n-1)
+		{
+			const V* ru = &R(i+1,0);
+			for(h=0;h<numV;++h) ri[h] = b[1]*cur[h] + b[2]*ru[h];
+		}
+		else if(i>0)
+		{
+			for(h=0;h<numV;++h) ri[h] = b[0]*prev[h] + b[1]*cur[h];
+		}
+		else
+		{
+			for(h=0;h<numV;++h) ri[h] = b[1]*cur[h];
+		}
+
+		//	shift
+		kInlines::swap(prev, cur);
+		for(h=0;h<3;++h)
+		{
+			al[h] = a[h];
+			a[h]  = au[h];
+		}
+		if(i+2<n) calcRow(i+2, one, dtTheta, wind, au);
+	}
+
+	//	done
+	return;
+}
+
+//	fused implicit step
+template <class V, class G>
+void
+kFd1d<V,G>::fusedImplicit(
+	V				one,
+	V				dtTheta,
+	int				wind,
+	bool			tr,
+	kMatrixView<V>	R)
+{
+	//	dims
+	int n	 = myX.size();
+	int numV = R.cols();
+	if(!n) return;
+
+	//	helps
+	int j, h;
+	V	al[3], a[3], bet, beti, g, l;
+
+	//	forward sweep, operator rows computed on the fly
+	calcRow(0, one, dtTheta, wind, a);
+	bet	 = a[1];
+	beti = 1.0/bet;
+	{
+		V* u0 = &R(0,0);
+		for(h=0;h<numV;++h) u0[h] = u0[h]*beti;
+	}
+	for(j=1;j<n;++j)
+	{
+		for(h=0;h<3;++h) al[h] = a[h];
+		calcRow(j, one, dtTheta, wind, a);
+
+		//	sub diagonal of row j and super diagonal of row j-1
+		l = tr ? al[2] : a[0];
+		g = (tr ? a[0] : al[2])*beti;
+		myGamf(j) = g;
+		bet	 = a[1]-l*g;
+		beti = 1.0/bet;
+
+		const V* ul = &R(j-1,0);
+		V*		 uj = &R(j,0);
+		for(h=0;h<numV;++h) uj[h] = (uj[h]-l*ul[h])*beti;
+	}
+
+	//	back substitution
+	for(j=n-2;j>=0;--j)
+	{
+		const V* uu = &R(j+1,0);
+		V*		 uj = &R(j,0);
+		g = myGamf(j+1);
+		for(h=0;h<numV;++h) uj[h] -= g*uu[h];
+	}
+
+	//	done
+	return;
+}
+
+//	build operator
+template <class V, class G>
+void
+kFd1d<V,G>::buildOp(
+	V				one,
+	V				dtTheta,
+	int				wind,
+	bool			tr,
+	bool			impl)
+{
+	if(impl)
+	{
+		++myNumFactor;
+		myObsDirty = true;
+	}
+
+	if(impl && parallel())
+	{
+		calcAx(one, dtTheta, wind, tr, myAi);
+		myPar.factor(myAi());
+	}
+	else if(myConst)
+	{
+		if(impl)
+		{
+			calcAc(one, dtTheta, wind, tr, myAic);
+			myStat = kMatrixAlgebra::tridagFactorConst(myAic(), myX.size(), myBeti(), myGam());
+		}
+		else
+		{
+			calcAc(one, dtTheta, wind, tr, myAec);
+		}
+	}
+	else
+	{
+		if(impl)
+		{
+			calcAx(one, dtTheta, wind, tr, myAi);
+			kMatrixAlgebra::tridagFactor(myAi, myBeti, myGam);
+		}
+		else
+		{
+			calcAx(one, dtTheta, wind, tr, myAe);
+		}
+	}
+
+	//	done
+	return;
+}
+
+//	explicit step
+template <class V, class G>
+void
+kFd1d<V,G>::applyOp(
+	const kMatrixView<V>	B,
+	kMatrixView<V>			X) const
+{
+	if(myConst)	kMatrixAlgebra::banmulMultiConst(myAec(), B, X);
+	else		kMatrixAlgebra::banmulMulti(myAe(), 1, 1, B, X);
+
+	//	done
+	return;
+}
+
+//	implicit step
+template <class V, class G>
+void
+kFd1d<V,G>::solveOp(
+	const kMatrixView<V>	R,
+	kMatrixView<V>			U)
+{
+	if(parallel())		myPar.solve(R, U);
+	else if(myConst)	kMatrixAlgebra::tridagSolveMultiConst(myAic(), myBeti(), myGam(), myStat, R, U);
+	else				kMatrixAlgebra::tridagSolveMulti(myAi(), myBeti(), myGam(), R, U);
+
+	//	done
+	return;
+}
+
+//	implicit step with obstacle
+template <class V, class G>
+void
+kFd1d<V,G>::solveObstacle(
+	V						dtTheta,
+	int						wind,
+	const kMatrixView<V>	R,
+	kMatrixView<V>			U,
+	const kSlotMatrix<V>&	obstacle,
+	Exercise				exercise)
+{
+	//	helps
+	int i, k;
+
+	//	dims
+	int n	 = myX.size();
+	int numV = R.cols();
+	if(!n) return;
+
+	//	full operator
+	bool own = myConst || parallel();
+	const kMatrix<V>& A = fullOp(dtTheta, wind);
+
+	//	workspace
+	myOr.resize(n);
+	myOg.resize(n);
+	myOu.resize(n);
+	myOd.resize(n);
+	myOw.resize(n);
+
+	//	slot by slot
+	for(k=0;k<numV;++k)
+	{
+		for(i=0;i<n;++i)
+		{
+			myOr(i) = R(i,k);
+			myOg(i) = obstacle(k,i);
+		}
+
+		if(exercise==penalty)
+		{
+			//	first guess: last values
+			for(i=0;i<n;++i) myOu(i) = U(i,k);
+			myNumPenalty += kMatrixAlgebra::tridagPenalty(A(), myOr(), myOg(), myOu(), myOd(), myOw(), myGamf());
+		}
+		else
+		{
+			//	exercise at the end where the obstacle is larger
+			bool low = myOg(0)>myOg(n-1);
+			if(low && !myObsUL)
+			{
+				kMatrixAlgebra::tridagFactorUL(A, myBetiu, myGamu);
+				myObsUL = true;
+			}
+			if(!low && own && !myObsLU)
+			{
+				kMatrixAlgebra::tridagFactor(A, myBetio, myGamo);
+				myObsLU = true;
+			}
+			const kVector<V>& beti = low ? myBetiu : own ? myBetio : myBeti;
+			const kVector<V>& gam  = low ? myGamu  : own ? myGamo  : myGam;
+			kMatrixAlgebra::tridagSolveProjected(A(), beti(), gam(), low, myOr(), myOg(), myOu());
+		}
+
+		for(i=0;i<n;++i) U(i,k) = myOu(i);
+	}
+
+	//	done
+	return;
+}
+
+//	full implicit operator
+template <class V, class G>
+const kMatrix<V>&
+kFd1d<V,G>::fullOp(
+	V						dtTheta,
+	int						wind)
+{
+	bool own = myConst || parallel();
+	if(myObsDirty)
+	{
+		if(own) calcAx(1.0, dtTheta, wind, false, myAo);
+		myObsDirty = false;
+		myObsLU	   = false;
+		myObsUL	   = false;
+	}
+
+	//	done
+	return own ? myAo : myAi;
+}
+
+//	compact operator
+template <class V, class G>
+void
+kFd1d<V,G>::calcAc(
+	V				one,
+	V				dtTheta,
+	int				wind,
+	bool			tr,
+	kMatrix<V>&		C) const
+{
+	//	dims
+	int n = myX.size();
+
+	//	helps
+	int j;
+	V	a0[3], ai[3], al[3];
+
+	//	rows of the first, an interior and the last node
+	calcRow(0,   one, dtTheta, wind, a0);
+	calcRow(1,   one, dtTheta, wind, ai);
+	calcRow(n-1, one, dtTheta, wind, al);
+
+	//	fill
+	C.resize(5, 3);
+	if(!tr)
+	{
+		for(j=0;j<3;++j)
 		{
-			myVs = res[k];
-			kMatrixAlgebra::banmul(myAe,mm,mm,myVs,res[k]);
+			C(0,j) = a0[j];
+			C(1,j) = ai[j];
+			C(2,j) = ai[j];
+			C(3,j) = ai[j];
+			C(4,j) = al[j];
 		}
 	}
+	else
+	{
+		//	transpose: row i is (A(i-1,2), A(i,1), A(i+1,0))
+		C(0,0) = a0[0];	C(0,1) = a0[1];	C(0,2) = ai[0];
+		C(1,0) = a0[2];	C(1,1) = ai[1];	C(1,2) = ai[0];
+		C(2,0) = ai[2];	C(2,1) = ai[1];	C(2,2) = ai[0];
+		C(3,0) = ai[2];	C(3,1) = ai[1];	C(3,2) = al[0];
+		C(4,0) = ai[2];	C(4,1) = al[1];	C(4,2) = al[2];
+	}
 
 	//	done
 	return;
@@ -0,0 +1,239 @@
+#pragma once
+
+//	desc:	adaptive time stepping on top of kFd1d
+//
+//	every step of size dt is taken once with dt and twice with dt/2, the
+//	difference estimates the local error of the half steps, which are kept:
+//
+//		err = max |V(dt) - V(dt/2, dt/2)| / 3
+//
+//	a step is accepted if err <= tol. the parabolic damping keeps the global
+//	error at a few tol. dt lives on the ladder t / 2^k, it is halved (or
+//	more) after a rejection and doubled after a step with plenty of margin,
+//	and always lands on t exactly. the full and the half steps run on two
+//	kFd1d workspaces that swap roles when dt moves by one level, so a dt
+//	change costs one factorization, none while dt stays put
+//
+//	usage mirrors kFd1d: init, fill r, mu, var and res, then roll. the
+//	coefficients are constant over a roll
+//
+
+//	includes
+#include "kFd1d.h"
+#include <cmath>
+
+//	class declaration
+template <class V, class G = kGridGeneral>
+class kFd1dAdaptive
+{
+public:
+
+	//	init
+	void	init(
+		int						numV,
+		const kVector<V>&		x,
+		bool					log)
+	{
+		myFd[0].init(numV, x, log);
+		myFd[1].init(numV, x, log);
+		myR.resize(x.size(), 0.0);
+		myMu.resize(x.size(), 0.0);
+		myVar.resize(x.size(), 0.0);
+		myRes.resize(numV, x.size());
+		myDt[0] = myDt[1] = 0.0;
+	}
+
+	const kVector<V>&		r()		const { return myR; }
+	const kVector<V>&		mu()	const { return myMu; }
+	const kVector<V>&		var()	const { return myVar; }
+	const kVector<V>&		x()		const { return myFd[0].x(); }
+	const kSlotMatrix<V>&	res()	const { return myRes; }
+
+	kVector<V>&				r()		{ return myR; }
+	kVector<V>&				mu()	{ return myMu; }
+	kVector<V>&				var()	{ return myVar; }
+	kSlotMatrix<V>&			res()	{ return myRes; }
+
+	//	settings: local error target, first step and finest ladder level
+	void	setTol(V tol)			{ myTol = tol; }
+	void	setDt0(V dt0)			{ myDt0 = dt0; }
+	void	setMaxLevel(int k)		{ myMaxLevel = max(0, min(k, 30)); }
+
+	//	roll bwd over t, obstacle (same dims as res) enforced in every step if given (brennan-schwartz)
+	void	rollBwd(
+		V						t,
+		V						theta,
+		int						wind,
+		const kSlotMatrix<V>*	obstacle = nullptr)
+	{
+		roll(false, t, theta, wind, obstacle);
+	}
+
+	//	roll fwd over t
+	void	rollFwd(
+		V						t,
+		V						theta,
+		int						wind)
+	{
+		roll(true, t, theta, wind, nullptr);
+	}
+
+	//	statistics of the last roll
+	int			numSteps()		const { return mySteps; }
+	int			numRejected()	const { return myRejected; }
+	long long	numFactor()		const { return myFactor; }
+
+	//	finest level reached without meeting tol
+	int			numForced()		const { return myForced; }
+
+private:
+
+	//	one step of size dt on workspace fd
+	void	step(
+		kFd1d<V,G>&				fd,
+		bool					fwd,
+		V						dt,
+		V						theta,
+		int						wind,
+		const kSlotMatrix<V>*	obstacle,
+		kSlotMatrix<V>&			res)
+	{
+		if(fwd) fd.rollFwd(dt, true, theta, wind, res);
+		else	fd.rollBwd(dt, true, theta, wind, res, obstacle);
+	}
+
+	//	roll
+	void	roll(
+		bool					fwd,
+		V						t,
+		V						theta,
+		int						wind,
+		const kSlotMatrix<V>*	obstacle);
+
+	//	workspaces, myFd[myA] takes the full steps, the other one the half steps
+	kFd1d<V,G>		myFd[2];
+	V				myDt[2]{0.0, 0.0};
+	int				myA{0};
+
+	//	coefficients and results
+	kVector<V>		myR, myMu, myVar;
+	kSlotMatrix<V>	myRes;
+
+	//	start of step and full step results
+	kSlotMatrix<V>	myStart, myFull;
+
+	//	settings
+	V				myTol{1.0e-6};
+	V				myDt0{0.0};
+	int				myMaxLevel{20};
+
+	//	statistics
+	int				mySteps{0};
+	int				myRejected{0};
+	int				myForced{0};
+	long long		myFactor{0};
+};
+
+//	roll
+template <class V, class G>
+void
+kFd1dAdaptive<V,G>::roll(
+	bool					fwd,
+	V						t,
+	V						theta,
+	int						wind,
+	const kSlotMatrix<V>*	obstacle)
+{
+	//	helps
+	int i, k, j;
+
+	//	stats
+	mySteps = myRejected = myForced = 0;
+	long long numF0 = myFd[0].numFactor() + myFd[1].numFactor();
+	if(t<=0.0)
+	{
+		myFactor = 0;
+		return;
+	}
+
+	//	coefficients into both workspaces, operators are only rebuilt if they changed
+	for(j=0;j<2;++j)
+	{
+		myFd[j].r()   = myR;
+		myFd[j].mu()  = myMu;
+		myFd[j].var() = myVar;
+	}
+
+	//	dims
+	int numV = myRes.numV();
+	int numX = myRes.numX();
+	myStart.resize(numV, numX);
+	myFull.resize(numV, numX);
+
+	//	ladder level of the first step, default t/16
+	V dt0 = myDt0>0.0 ? myDt0 : t/16.0;
+	int lev = 0;
+	while(lev<myMaxLevel && t/(V)(1LL<<lev)>dt0) ++lev;
+
+	//	position: pos steps of t/2^lev done
+	long long pos = 0;
+	while(pos<(1LL<<lev))
+	{
+		V dt = t/(V)(1LL<<lev);
+
+		//	workspaces for dt and dt/2, swap roles if that saves a factorization
+		if(myDt[myA]==0.5*dt || myDt[1-myA]==dt) myA = 1-myA;
+		kFd1d<V,G>& fdF = myFd[myA];
+		kFd1d<V,G>& fdH = myFd[1-myA];
+		myDt[myA]	= dt;
+		myDt[1-myA] = 0.5*dt;
+
+		//	full step on a copy, two half steps in place
+		myRes.copyTo(myStart);
+		myRes.copyTo(myFull);
+		step(fdF, fwd, dt, theta, wind, obstacle, myFull);
+		step(fdH, fwd, 0.5*dt, theta, wind, obstacle, myRes);
+		step(fdH, fwd, 0.5*dt, theta, wind, obstacle, myRes);
+
+		//	error estimate
+		V err = 0.0;
+		for(k=0;k<numV;++k)
+		{
+			for(i=0;i<numX;++i) err = max(err, V(fabs(myRes(k,i) - myFull(k,i))));
+		}
+		err /= 3.0;
+
+		//	local error scales as dt^3
+		V fac = err>0.0 ? 0.9*cbrt(myTol/err) : V(4.0);
+
+		//	reject: restore and refine
+		if(err>myTol && lev<myMaxLevel)
+		{
+			++myRejected;
+			myStart.copyTo(myRes);
+			int d = 1;
+			while(d<myMaxLevel-lev && fac<1.0/(V)(1LL<<d)) ++d;
+			lev += d;
+			pos <<= d;
+			continue;
+		}
+
+		//	accept
+		if(err>myTol) ++myForced;
+		++mySteps;
+		++pos;
+
+		//	grow one level if aligned on the coarser ladder
+		if(fac>=2.0 && lev>0 && (pos & 1)==0)
+		{
+			--lev;
+			pos >>= 1;
+		}
+	}
+
+	//	factorizations
+	myFactor = myFd[0].numFactor() + myFd[1].numFactor() - numF0;
+
+	//	done
+	return;
+}
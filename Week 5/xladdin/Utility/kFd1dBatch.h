@@ -0,0 +1,399 @@
+#pragma once
+
+//	desc:	W independent 1d finite difference problems of the kFd1d form
+//
+//		0 = dV/dt + A V
+//
+//		A = -r + mu d/dx + 1/2 var d^2/dx^2
+//
+//	rolled backwards in lockstep with the theta scheme, one problem per lane.
+//	lanes share the number of nodes, theta and wind but have their own grid,
+//	coefficients and time step. storage is node major with the lane index
+//	inner, so every kernel loop runs across the W lanes and maps onto simd
+//	registers (W = 4 for avx2 doubles, 8 for avx-512 doubles)
+//
+//	operators are stored n x 3W with element (i,j) of lane w at (i,j*W+w)
+//
+
+//	includes
+#include "kFiniteDifference.h"
+#include "kMatrixAlgebra.h"
+
+//	class declaration
+template <class V, int W = 4>
+class kFd1dBatch
+{
+public:
+
+	//	number of lanes
+	static constexpr int numW = W;
+
+	//	init: numx nodes for all lanes
+	void	init(
+		int						numx);
+
+	//	init grid of lane w
+	void	initLane(
+		int						w,
+		const kVector<V>&		x,
+		bool					log);
+
+	//	numx x W: element (i,w) is node i of lane w
+	const kMatrix<V>&			x()		const { return myX; }
+	const kMatrix<V>&			r()		const { return myR; }
+	const kMatrix<V>&			mu()	const { return myMu; }
+	const kMatrix<V>&			var()	const { return myVar; }
+	const kMatrix<V>&			res()	const { return myRes; }
+
+	kMatrix<V>&					r()		{ return myR; }
+	kMatrix<V>&					mu()	{ return myMu; }
+	kMatrix<V>&					var()	{ return myVar; }
+	kMatrix<V>&					res()	{ return myRes; }
+
+	//	operator
+	void	calcAx(
+		V						one,
+		const V*				dtTheta,	//	W
+		int						wind,
+		kMatrix<V>&				A) const;
+
+	//	roll bwd, dt per lane
+	void	rollBwd(
+		const kVector<V>&		dt,			//	W
+		bool					update,
+		V						theta,
+		int						wind);
+
+	//	american projection res = max(res, obstacle)
+	void	project(
+		const kMatrix<V>&		obstacle);	//	numx x W
+
+private:
+
+	//	lane kernels
+	static void	banmul(
+		const kMatrix<V>&		A,
+		const kMatrix<V>&		b,
+		kMatrix<V>&				x);
+
+	static void	tridagFactor(
+		const kMatrix<V>&		A,
+		kMatrix<V>&				beti,
+		kMatrix<V>&				gam);
+
+	static void	tridagSolve(
+		const kMatrix<V>&		A,
+		const kMatrix<V>&		beti,
+		const kMatrix<V>&		gam,
+		kMatrix<V>&				u);
+
+	//	x, r, mu, var
+	kMatrix<V>	myX, myR, myMu, myVar;
+
+	//	diff operators, interleaved
+	kMatrix<V>	myDxd, myDxu, myDx, myDxx;
+
+	//	operator matrices and factorization of the implicit one
+	kMatrix<V>	myAe, myAi, myBeti, myGam;
+
+	//	helpers
+	kMatrix<V>	myVs, myDx1;
+
+	//	results
+	kMatrix<V>	myRes;
+};
+
+//	init
+template <class V, int W>
+void
+kFd1dBatch<V,W>::init(
+	int					numx)
+{
+	//	dims
+	int n = max(0, numx);
+
+	//	resize
+	myX.resize(n, W, 0.0);
+	myR.resize(n, W, 0.0);
+	myMu.resize(n, W, 0.0);
+	myVar.resize(n, W, 0.0);
+	myRes.resize(n, W, 0.0);
+	myDxd.resize(n, 3*W, 0.0);
+	myDxu.resize(n, 3*W, 0.0);
+	myDx.resize(n, 3*W, 0.0);
+	myDxx.resize(n, 3*W, 0.0);
+	myAe.resize(n, 3*W);
+	myAi.resize(n, 3*W);
+	myBeti.resize(n, W);
+	myGam.resize(n, W);
+	myVs.resize(n, W);
+
+	//	done
+	return;
+}
+
+//	init grid of lane w
+template <class V, int W>
+void
+kFd1dBatch<V,W>::initLane(
+	int					w,
+	const kVector<V>&	x,
+	bool				log)
+{
+	//	dims
+	int n = myX.rows();
+	int i, j;
+
+	//	x
+	for(i=0;i<n;++i) myX(i,w) = x(i);
+
+	//	scalar stencils, then interleave
+	kFiniteDifference::dx(-1, x, myDx1);
+	for(i=0;i<n;++i) for(j=0;j<3;++j) myDxd(i,j*W+w) = myDx1(i,j);
+	kFiniteDifference::dx( 1, x, myDx1);
+	for(i=0;i<n;++i) for(j=0;j<3;++j) myDxu(i,j*W+w) = myDx1(i,j);
+	kFiniteDifference::dx( 0, x, myDx1);
+	for(i=0;i<n;++i) for(j=0;j<3;++j) myDx(i,j*W+w) = myDx1(i,j);
+	kFiniteDifference::dxx(   x, myDx1);
+	for(i=0;i<n;++i) for(j=0;j<3;++j) myDxx(i,j*W+w) = myDx1(i,j);
+
+	//	log transform case
+	if(log)
+	{
+		for(i=1;i<n-1;++i)
+		{
+			for(j=0;j<3;++j) myDxx(i,j*W+w) -= myDx(i,j*W+w);
+		}
+	}
+
+	//	done
+	return;
+}
+
+//	construct operator
+template <class V, int W>
+void
+kFd1dBatch<V,W>::calcAx(
+	V				one,
+	const V*		dtTheta,
+	int				wind,
+	kMatrix<V>&		A) const
+{
+	//	dims
+	int n = myX.rows();
+
+	//	helps
+	int i, j, w;
+	V	dxj;
+
+	//	wind
+	const kMatrix<V>*	Dx = &myDx;
+	if(wind<0)			Dx = &myDxd;
+	else if(wind==1)	Dx = &myDxu;
+
+	//	fill
+	A.resize(n, 3*W);
+	for(i=0;i<n;++i)
+	{
+		const V* mu  = &myMu(i,0);
+		const V* var = &myVar(i,0);
+		const V* r	 = &myR(i,0);
+		V*		 a	 = &A(i,0);
+		for(j=0;j<3;++j)
+		{
+			const V* dx	 = &(*Dx)(i,j*W);
+			const V* dxd = &myDxd(i,j*W);
+			const V* dxu = &myDxu(i,j*W);
+			const V* dxx = &myDxx(i,j*W);
+			for(w=0;w<W;++w)
+			{
+				dxj = wind>1 ? (mu[w]<0.0 ? dxd[w] : dxu[w]) : dx[w];
+				a[j*W+w] = dtTheta[w] * (mu[w]*dxj + 0.5*var[w]*dxx[w]);
+			}
+		}
+		for(w=0;w<W;++w) a[W+w] += one - dtTheta[w]*r[w];
+	}
+
+	//	done
+	return;
+}
+
+//	band multiplication x = A b per lane
+template <class V, int W>
+void
+kFd1dBatch<V,W>::banmul(
+	const kMatrix<V>&	A,
+	const kMatrix<V>&	b,
+	kMatrix<V>&			x)
+{
+	//	dims
+	int n = A.rows()-1;
+	if(n<0) return;
+
+	//	helps
+	int i, w;
+
+	//	single node
+	if(n==0)
+	{
+		for(w=0;w<W;++w) x(0,w) = A(0,W+w)*b(0,w);
+		return;
+	}
+
+	//	first row
+	{
+		const V* a = &A(0,0);
+		for(w=0;w<W;++w) x(0,w) = a[W+w]*b(0,w) + a[2*W+w]*b(1,w);
+	}
+
+	//	interior
+	for(i=1;i<n;++i)
+	{
+		const V* a	= &A(i,0);
+		const V* bl	= &b(i-1,0);
+		const V* bi	= &b(i,0);
+		const V* bu	= &b(i+1,0);
+		V*		 xi	= &x(i,0);
+		for(w=0;w<W;++w) xi[w] = a[w]*bl[w] + a[W+w]*bi[w] + a[2*W+w]*bu[w];
+	}
+
+	//	last row
+	{
+		const V* a = &A(n,0);
+		for(w=0;w<W;++w) x(n,w) = a[w]*b(n-1,w) + a[W+w]*b(n,w);
+	}
+
+	//	done
+	return;
+}
+
+//	tridag factor per lane
+template <class V, int W>
+void
+kFd1dBatch<V,W>::tridagFactor(
+	const kMatrix<V>&	A,
+	kMatrix<V>&			beti,
+	kMatrix<V>&			gam)
+{
+	//	dims
+	int n = A.rows();
+	if(!n) return;
+
+	//	helps
+	int j, w;
+
+	//	go
+	for(w=0;w<W;++w) beti(0,w) = 1.0/A(0,W+w);
+	for(j=1;j<n;++j)
+	{
+		const V* al	= &A(j-1,0);
+		const V* a	= &A(j,0);
+		const V* bl	= &beti(j-1,0);
+		V*		 b	= &beti(j,0);
+		V*		 g	= &gam(j,0);
+		for(w=0;w<W;++w)
+		{
+			g[w] = al[2*W+w]*bl[w];
+			b[w] = 1.0/(a[W+w]-a[w]*g[w]);
+		}
+	}
+
+	//	done
+	return;
+}
+
+//	tridag solve per lane, in place
+template <class V, int W>
+void
+kFd1dBatch<V,W>::tridagSolve(
+	const kMatrix<V>&	A,
+	const kMatrix<V>&	beti,
+	const kMatrix<V>&	gam,
+	kMatrix<V>&			u)
+{
+	//	dims
+	int n = A.rows();
+	if(!n) return;
+
+	//	helps
+	int j, w;
+
+	//	go
+	for(w=0;w<W;++w) u(0,w) *= beti(0,w);
+	for(j=1;j<n;++j)
+	{
+		const V* a	= &A(j,0);
+		const V* b	= &beti(j,0);
+		const V* ul	= &u(j-1,0);
+		V*		 uj	= &u(j,0);
+		for(w=0;w<W;++w) uj[w] = (uj[w]-a[w]*ul[w])*b[w];
+	}
+	for(j=n-2;j>=0;--j)
+	{
+		const V* g	= &gam(j+1,0);
+		const V* uu	= &u(j+1,0);
+		V*		 uj	= &u(j,0);
+		for(w=0;w<W;++w) uj[w] -= g[w]*uu[w];
+	}
+
+	//	done
+	return;
+}
+
+//	roll bwd
+template <class V, int W>
+void
+kFd1dBatch<V,W>::rollBwd(
+	const kVector<V>&	dt,
+	bool				update,
+	V					theta,
+	int					wind)
+{
+	//	helps
+	int w;
+	V	dtTheta[W];
+
+	//	explicit
+	if(theta!=1.0)
+	{
+		if(update)
+		{
+			for(w=0;w<W;++w) dtTheta[w] = dt(w)*(1.0-theta);
+			calcAx(1.0, dtTheta, wind, myAe);
+		}
+		myVs = myRes;
+		banmul(myAe, myVs, myRes);
+	}
+
+	//	implicit
+	if(theta!=0.0)
+	{
+		if(update)
+		{
+			for(w=0;w<W;++w) dtTheta[w] = -dt(w)*theta;
+			calcAx(1.0, dtTheta, wind, myAi);
+			tridagFactor(myAi, myBeti, myGam);
+		}
+		tridagSolve(myAi, myBeti, myGam, myRes);
+	}
+
+	//	done
+	return;
+}
+
+//	american projection
+template <class V, int W>
+void
+kFd1dBatch<V,W>::project(
+	const kMatrix<V>&	obstacle)
+{
+	//	helps
+	int i;
+
+	//	all lanes
+	int m = myRes.size();
+	for(i=0;i<m;++i) myRes[i] = max(myRes[i], obstacle[i]);
+
+	//	done
+	return;
+}
@@ -0,0 +1,390 @@
+#pragma once
+
+//	desc:	kFd1d with results in single precision
+//
+//	numV result slots are stored as floats, node major, and rolled with the
+//	theta scheme of kFd1d. grid, coefficients and operators stay in double,
+//	the kernels read floats and compute in double: the explicit step
+//	accumulates in double, the tridag sweeps carry their recurrence in
+//	double and round once per node. the results take half the memory
+//	traffic of kFd1d<double>, which dominates the multi slot kernels
+//
+//	the implicit solve runs on a float copy of the factorization. on fine
+//	grids the entries of [1 - dt theta A] are large and nearly cancel, so
+//	the rounded factors give relative errors of about dt var / dx^2 float
+//	epsilons per step. with refine on, one step of iterative refinement
+//	takes the residual R - Ai U with the double operator and solves for the
+//	correction with the float factors, which brings the error down to the
+//	float rounding of the results
+//
+//	kFd1d<float> itself compiles and runs but also takes the grid and the
+//	stencils in float, dx loses most of its digits on fine grids
+
+//	includes
+#include "kFd1d.h"
+
+//	class declaration
+template <class G = kGridGeneral>
+class kFd1dMixed
+{
+public:
+
+	//	init
+	void	init(
+		int						numV,
+		const kVector<double>&	x,
+		bool					log);
+
+	const kVector<double>&		r()		const { return myFd.r(); }
+	const kVector<double>&		mu()	const { return myFd.mu(); }
+	const kVector<double>&		var()	const { return myFd.var(); }
+	const kVector<double>&		x()		const { return myFd.x(); }
+	const kMatrix<float>&		res()	const { return myRes; }
+
+	kVector<double>&			r()		{ return myFd.r(); }
+	kVector<double>&			mu()	{ return myFd.mu(); }
+	kVector<double>&			var()	{ return myFd.var(); }
+	kMatrix<float>&				res()	{ return myRes; }
+
+	//	one step of iterative refinement of the implicit solve in double
+	bool						refine() const { return myRefine; }
+	void						setRefine(bool on) { myRefine = on; }
+
+	//	roll bwd
+	void	rollBwd(
+		double					dt,
+		bool					update,
+		double					theta,
+		int						wind);
+
+	//	roll fwd
+	void	rollFwd(
+		double					dt,
+		bool					update,
+		double					theta,
+		int						wind);
+
+private:
+
+	//	build operators, float factorization of the implicit one
+	void	buildOp(
+		double					dt,
+		double					theta,
+		int						wind,
+		bool					tr);
+
+	//	implicit step Ai U = R, refined if on, U and R may be the same without refinement
+	void	solveOp(
+		const kMatrix<float>&	R,
+		kMatrix<float>&			U);
+
+	//	band multiplication X = A B, accumulated in double
+	static void	banmul(
+		const kMatrix<double>&	A,
+		const kMatrix<float>&	B,
+		kMatrix<float>&			X);
+
+	//	tridag solve Ai U = R with the float factorization, recurrence carried in double, U and R may be the same
+	void	tridagSolve(
+		const kMatrix<float>&	R,
+		kMatrix<float>&			U);
+
+	//	refinement U += Ai^-1 (R - Ai U), the residual in double formed in the forward sweep
+	void	refineSolve(
+		const kMatrix<float>&	R,
+		kMatrix<float>&			U);
+
+	//	grid, coefficients and operator construction
+	kFd1d<double,G>		myFd;
+
+	//	operators
+	kMatrix<double>		myAe, myAi;
+
+	//	factorization of the implicit operator: sub diagonal, 1/bet and gam in float
+	kVector<double>		myBetid, myGamd;
+	kVector<float>		myAl, myBeti, myGam;
+
+	//	refinement
+	bool				myRefine{false};
+
+	//	helpers
+	kMatrix<float>		myVs, myE;
+	kVector<double>		myCarry;
+
+	//	results, n x numV
+	kMatrix<float>		myRes;
+};
+
+//	init
+template <class G>
+void
+kFd1dMixed<G>::init(
+	int						numV,
+	const kVector<double>&	x,
+	bool					log)
+{
+	//	grid
+	myFd.init(1, x, log);
+
+	//	dims
+	int n = x.size();
+	myRes.resize(n, numV, 0.0f);
+	myVs.resize(n, numV);
+	myCarry.resize(numV);
+
+	//	done
+	return;
+}
+
+//	build operators
+template <class G>
+void
+kFd1dMixed<G>::buildOp(
+	double					dt,
+	double					theta,
+	int						wind,
+	bool					tr)
+{
+	//	explicit
+	if(theta!=1.0) myFd.calcAx(1.0, dt*(1.0-theta), wind, tr, myAe);
+
+	//	implicit, factorization in double rounded to float
+	if(theta!=0.0)
+	{
+		myFd.calcAx(1.0, -dt*theta, wind, tr, myAi);
+		kMatrixAlgebra::tridagFactor(myAi, myBetid, myGamd);
+		int n = myAi.rows();
+		myAl.resize(n);
+		myBeti.resize(n);
+		myGam.resize(n);
+		for(int i=0;i<n;++i)
+		{
+			myAl(i)	  = (float)myAi(i,0);
+			myBeti(i) = (float)myBetid(i);
+			myGam(i)  = (float)myGamd(i);
+		}
+	}
+
+	//	done
+	return;
+}
+
+//	band multiplication
+template <class G>
+void
+kFd1dMixed<G>::banmul(
+	const kMatrix<double>&	A,
+	const kMatrix<float>&	B,
+	kMatrix<float>&			X)
+{
+	//	dims
+	int n	 = A.rows()-1;
+	int numV = B.cols();
+	if(n<0) return;
+
+	//	helps
+	int i, h;
+
+	//	single node
+	if(n==0)
+	{
+		for(h=0;h<numV;++h) X(0,h) = (float)(A(0,1)*B(0,h));
+		return;
+	}
+
+	//	first row
+	{
+		const double* a = &A(0,0);
+		const float* bi = &B(0,0);
+		const float* bu = &B(1,0);
+		float*		 xi = &X(0,0);
+		for(h=0;h<numV;++h) xi[h] = (float)(a[1]*bi[h] + a[2]*bu[h]);
+	}
+
+	//	interior
+	for(i=1;i<n;++i)
+	{
+		const double* a = &A(i,0);
+		const float* bl = &B(i-1,0);
+		const float* bi = &B(i,0);
+		const float* bu = &B(i+1,0);
+		float*		 xi = &X(i,0);
+		for(h=0;h<numV;++h) xi[h] = (float)(a[0]*bl[h] + a[1]*bi[h] + a[2]*bu[h]);
+	}
+
+	//	last row
+	{
+		const double* a = &A(n,0);
+		const float* bl = &B(n-1,0);
+		const float* bi = &B(n,0);
+		float*		 xi = &X(n,0);
+		for(h=0;h<numV;++h) xi[h] = (float)(a[0]*bl[h] + a[1]*bi[h]);
+	}
+
+	//	done
+	return;
+}
+
+//	tridag solve
+template <class G>
+void
+kFd1dMixed<G>::tridagSolve(
+	const kMatrix<float>&	R,
+	kMatrix<float>&			U)
+{
+	//	dims
+	int n	 = R.rows();
+	int numV = R.cols();
+	U.resize(n, numV);
+	if(!n) return;
+
+	//	helps
+	int j, h;
+	double* c = myCarry.data().data();
+
+	//	forward, the carry ends on the last node
+	{
+		double b = myBeti(0);
+		const float* rj = &R(0,0);
+		float*		 uj = &U(0,0);
+		for(h=0;h<numV;++h) uj[h] = (float)(c[h] = rj[h]*b);
+	}
+	for(j=1;j<n;++j)
+	{
+		double a = myAl(j);
+		double b = myBeti(j);
+		const float* rj = &R(j,0);
+		float*		 uj = &U(j,0);
+		for(h=0;h<numV;++h) uj[h] = (float)(c[h] = (rj[h] - a*c[h])*b);
+	}
+
+	//	backward
+	for(j=n-2;j>=0;--j)
+	{
+		double g = myGam(j+1);
+		float* uj = &U(j,0);
+		for(h=0;h<numV;++h) uj[h] = (float)(c[h] = uj[h] - g*c[h]);
+	}
+
+	//	done
+	return;
+}
+
+//	refinement
+template <class G>
+void
+kFd1dMixed<G>::refineSolve(
+	const kMatrix<float>&	R,
+	kMatrix<float>&			U)
+{
+	//	dims
+	int n	 = U.rows();
+	int numV = U.cols();
+	myE.resize(n, numV);
+	if(!n) return;
+
+	//	helps
+	int j, h;
+	double* c = myCarry.data().data();
+
+	//	forward over the residual rows, the missing neighbours of the end nodes read as zero
+	for(j=0;j<n;++j)
+	{
+		const double* a = &myAi(j,0);
+		double al = j>0 ? a[0] : 0.0;
+		double au = j<n-1 ? a[2] : 0.0;
+		double b  = myBeti(j);
+		double l  = j>0 ? myAl(j) : 0.0;
+		const float* rj = &R(j,0);
+		const float* uj = &U(j,0);
+		const float* ul = j>0 ? &U(j-1,0) : uj;
+		const float* uu = j<n-1 ? &U(j+1,0) : uj;
+		float*		 ej = &myE(j,0);
+		for(h=0;h<numV;++h)
+		{
+			double e = rj[h] - (al*ul[h] + a[1]*uj[h] + au*uu[h]);
+			ej[h] = (float)(c[h] = (e - l*c[h])*b);
+		}
+	}
+
+	//	backward, corrections added to U
+	{
+		float* uj = &U(n-1,0);
+		for(h=0;h<numV;++h) uj[h] = (float)(uj[h] + c[h]);
+	}
+	for(j=n-2;j>=0;--j)
+	{
+		double g = myGam(j+1);
+		const float* ej = &myE(j,0);
+		float*		 uj = &U(j,0);
+		for(h=0;h<numV;++h) uj[h] = (float)(uj[h] + (c[h] = ej[h] - g*c[h]));
+	}
+
+	//	done
+	return;
+}
+
+//	implicit step
+template <class G>
+void
+kFd1dMixed<G>::solveOp(
+	const kMatrix<float>&	R,
+	kMatrix<float>&			U)
+{
+	//	solve
+	tridagSolve(R, U);
+
+	//	refine
+	if(myRefine) refineSolve(R, U);
+
+	//	done
+	return;
+}
+
+//	roll bwd
+template <class G>
+void
+kFd1dMixed<G>::rollBwd(
+	double					dt,
+	bool					update,
+	double					theta,
+	int						wind)
+{
+	//	only rebuild operators if something changed
+	if(update && myFd.isDirty(dt, theta, wind, false)) buildOp(dt, theta, wind, false);
+
+	//	explicit into helper
+	if(theta!=1.0)	banmul(myAe, myRes, myVs);
+	else			myVs = myRes;
+
+	//	implicit
+	if(theta!=0.0)	solveOp(myVs, myRes);
+	else			myRes = myVs;
+
+	//	done
+	return;
+}
+
+//	roll fwd
+template <class G>
+void
+kFd1dMixed<G>::rollFwd(
+	double					dt,
+	bool					update,
+	double					theta,
+	int						wind)
+{
+	//	only rebuild operators if something changed
+	if(update && myFd.isDirty(dt, theta, wind, true)) buildOp(dt, theta, wind, true);
+
+	//	implicit into helper
+	if(theta!=0.0)	solveOp(myRes, myVs);
+	else			myVs = myRes;
+
+	//	explicit
+	if(theta!=1.0)	banmul(myAe, myVs, myRes);
+	else			myRes = myVs;
+
+	//	done
+	return;
+}
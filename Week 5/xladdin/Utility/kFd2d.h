@@ -0,0 +1,547 @@
+#pragma once
+
+//	desc:	2d finite difference solution for pdes of the form
+//
+//		0 = dV/dt + A V
+//
+//		A = -r + mux d/dx + muy d/dy + 1/2 varx d^2/dx^2 + 1/2 vary d^2/dy^2 + cov d^2/dxdy
+//
+//	by alternating direction implicit schemes. A is split into the mixed
+//	term A0 and the x and y terms A1 and A2, r going half to each, and a
+//	step from t+dt to t runs through (U = V(t+dt), theta the implicit weight)
+//
+//		Y0 = U + dt A U
+//		Yj = Y(j-1) + theta dt Aj (Yj - U),		j = 1, 2
+//
+//	which is douglas. the other schemes correct Y0 with Y2 and sweep again:
+//
+//		Z0 = Y0 + c0 dt A0 (Y2 - U) + c dt A (Y2 - U)
+//		Zj = Z(j-1) + theta dt Aj (Zj - W),		j = 1, 2
+//
+//	(c0, c, W) = (1/2, 0, U) for craig-sneyd, (theta, 1/2 - theta, U) for
+//	modified craig-sneyd and (0, 1/2, Y2) for hundsdorfer-verwer. the d/dx
+//	and d^2/dx^2 stencils are those of kFiniteDifference per dimension, the
+//	mixed term is the product of the central ones
+//
+//	values and coefficients are nx x ny matrices, y lines contiguous. the x
+//	lines are solved in place, all lines of a block of columns at once, so
+//	the sweeps run down contiguous rows (kMatrixAlgebra::tridagSolveLines).
+//	the y lines are solved the same way on a transposed copy, the transposes
+//	go in cache sized tiles. the explicit products need no transpose. the
+//	operators are assembled and factored once per change of step, or when
+//	update is set. with setParallel the column blocks, transpose tiles and
+//	rows of the explicit products are spread over the threads of a pool. do
+//	not use it from tasks running on the same pool
+//
+
+//	includes
+#include "kFiniteDifference.h"
+#include "kMatrixAlgebra.h"
+#include "kThreadPool.h"
+
+//	class declaration
+template <class V>
+class kFd2d
+{
+public:
+
+	//	schemes
+	enum Scheme
+	{
+		douglas,
+		craigSneyd,
+		modifiedCraigSneyd,
+		hundsdorferVerwer
+	};
+
+	//	init, coefficients and results are nx x ny
+	void	init(
+		const kVector<V>&		x,
+		const kVector<V>&		y);
+
+	const kVector<V>&		x()		const { return myX; }
+	const kVector<V>&		y()		const { return myY; }
+	const kMatrix<V>&		r()		const { return myR; }
+	const kMatrix<V>&		mux()	const { return myMux; }
+	const kMatrix<V>&		muy()	const { return myMuy; }
+	const kMatrix<V>&		varx()	const { return myVarx; }
+	const kMatrix<V>&		vary()	const { return myVary; }
+	const kMatrix<V>&		cov()	const { return myCov; }
+	const kMatrix<V>&		res()	const { return myRes; }
+
+	kMatrix<V>&				r()		{ return myR; }
+	kMatrix<V>&				mux()	{ return myMux; }
+	kMatrix<V>&				muy()	{ return myMuy; }
+	kMatrix<V>&				varx()	{ return myVarx; }
+	kMatrix<V>&				vary()	{ return myVary; }
+	kMatrix<V>&				cov()	{ return myCov; }
+	kMatrix<V>&				res()	{ return myRes; }
+
+	//	threaded sweeps, null pool for the shared one
+	void	setParallel(
+		bool					on,
+		kThreadPool*			pool = nullptr)
+	{
+		myParOn = on;
+		myPool	= pool;
+	}
+
+	//	roll bwd, operators rebuilt if update or dt, theta, wind changed
+	void	rollBwd(
+		V						dt,
+		bool					update,
+		V						theta,
+		int						wind,
+		Scheme					scheme = hundsdorferVerwer);
+
+private:
+
+	//	columns per block of line solves
+	static constexpr int	block = 32;
+
+	//	run f(task) for task = 0..n-1, on the pool if parallel
+	template <class F>
+	void	forTasks(
+		int						n,
+		const F&				f)
+	{
+		if(myParOn && n>1)	pool().parallelFor(n, [&](int l, int) { f(l); });
+		else				for(int l=0;l<n;++l) f(l);
+	}
+
+	//	pool
+	kThreadPool&	pool() const { return myPool ? *myPool : kThreadPool::global(); }
+
+	//	build dt Aj and the factored [1 - theta dt Aj]
+	void	buildOp(
+		V						dt,
+		V						theta,
+		int						wind);
+
+	//	operator row: a = dt (mu dx + 1/2 var dxx - 1/2 r) at node i
+	void	calcRow(
+		const kStencil<V>&		dxd,
+		const kStencil<V>&		dx,
+		const kStencil<V>&		dxu,
+		const kStencil<V>&		dxx,
+		int						i,
+		V						dt,
+		V						mu,
+		V						var,
+		V						r,
+		int						wind,
+		V*						a) const;
+
+	//	B = A^T
+	void	transpose(
+		const kMatrix<V>&		A,
+		kMatrix<V>&				B);
+
+	//	X = dt A1 B
+	void	applyX(
+		const kMatrix<V>&		B,
+		kMatrix<V>&				X);
+
+	//	X = dt A2 B
+	void	applyY(
+		const kMatrix<V>&		B,
+		kMatrix<V>&				X);
+
+	//	X = dt A0 B
+	void	applyXY(
+		const kMatrix<V>&		B,
+		kMatrix<V>&				X);
+
+	//	x and y sweeps: Y -= theta Wx, solve x, Y -= theta Wy, solve y, in place
+	void	sweeps(
+		V						theta,
+		const kMatrix<V>&		Wx,
+		const kMatrix<V>&		Wy,
+		kMatrix<V>&				Y);
+
+	//	grid, coefficients, results
+	kVector<V>		myX, myY;
+	kMatrix<V>		myR, myMux, myMuy, myVarx, myVary, myCov;
+	kMatrix<V>		myRes;
+
+	//	stencils per dimension
+	kStencil<V>		myDxd, myDx, myDxu, myDxx;
+	kStencil<V>		myDyd, myDy, myDyu, myDyy;
+
+	//	diagonals of dt A1 and dt A2 (nx x ny), of [1 - theta dt A1] (nx x ny)
+	//	and [1 - theta dt A2] (transposed, ny x nx), and the factorizations
+	kMatrix<V>		myEx[3], myEy[3], myMx[3], myMy[3];
+	kMatrix<V>		myBetix, myGamx, myBetiy, myGamy;
+
+	//	operator cache
+	V				myDtc{0.0}, myThetac{-1.0};
+	int				myWindc{0};
+
+	//	explicit products of U and Y2, first and second stage values, transposed work
+	kMatrix<V>		myF0, myF1, myF2, myG0, myG1, myG2;
+	kMatrix<V>		myY0, myYs, myTt;
+
+	//	threads
+	bool			myParOn{false};
+	kThreadPool*	myPool{nullptr};
+};
+
+//	init
+template <class V>
+void
+kFd2d<V>::init(
+	const kVector<V>&	x,
+	const kVector<V>&	y)
+{
+	myX = x;
+	myY = y;
+	int nx = myX.size();
+	int ny = myY.size();
+
+	//	coefficients and results
+	myR.resize(nx, ny);
+	myMux.resize(nx, ny);
+	myMuy.resize(nx, ny);
+	myVarx.resize(nx, ny);
+	myVary.resize(nx, ny);
+	myCov.resize(nx, ny);
+	myRes.resize(nx, ny);
+
+	//	stencils
+	kFiniteDifference::dx(-1, myX, myDxd);
+	kFiniteDifference::dx( 0, myX, myDx);
+	kFiniteDifference::dx( 1, myX, myDxu);
+	kFiniteDifference::dxx(   myX, myDxx);
+	kFiniteDifference::dx(-1, myY, myDyd);
+	kFiniteDifference::dx( 0, myY, myDy);
+	kFiniteDifference::dx( 1, myY, myDyu);
+	kFiniteDifference::dxx(   myY, myDyy);
+
+	//	operators
+	for(int h=0;h<3;++h)
+	{
+		myEx[h].resize(nx, ny);
+		myEy[h].resize(nx, ny);
+		myMx[h].resize(nx, ny);
+		myMy[h].resize(ny, nx);
+	}
+	myBetix.resize(nx, ny);
+	myGamx.resize(nx, ny);
+	myBetiy.resize(ny, nx);
+	myGamy.resize(ny, nx);
+	myThetac = -1.0;
+
+	//	work
+	myF0.resize(nx, ny);
+	myF1.resize(nx, ny);
+	myF2.resize(nx, ny);
+	myG0.resize(nx, ny);
+	myG1.resize(nx, ny);
+	myG2.resize(nx, ny);
+	myY0.resize(nx, ny);
+	myYs.resize(nx, ny);
+	myTt.resize(ny, nx);
+
+	//	done
+	return;
+}
+
+//	operator row
+template <class V>
+void
+kFd2d<V>::calcRow(
+	const kStencil<V>&	dxd,
+	const kStencil<V>&	dx,
+	const kStencil<V>&	dxu,
+	const kStencil<V>&	dxx,
+	int					i,
+	V					dt,
+	V					mu,
+	V					var,
+	V					r,
+	int					wind,
+	V*					a) const
+{
+	//	wind
+	const kStencil<V>* D = &dx;
+	if(wind<0)			D = &dxd;
+	else if(wind==1)	D = &dxu;
+	else if(wind>1)		D = mu<0.0 ? &dxd : &dxu;
+
+	for(int j=0;j<3;++j) a[j] = dt * (mu*(*D)(i,j) + 0.5*var*dxx(i,j));
+	a[1] -= 0.5*dt*r;
+
+	//	done
+	return;
+}
+
+//	build operators
+template <class V>
+void
+kFd2d<V>::buildOp(
+	V				dt,
+	V				theta,
+	int				wind)
+{
+	//	dims
+	int nx = myX.size();
+	int ny = myY.size();
+
+	//	rows of both operators at every node
+	forTasks(nx, [&](int i)
+	{
+		V a[3];
+		for(int j=0;j<ny;++j)
+		{
+			calcRow(myDxd, myDx, myDxu, myDxx, i, dt, myMux(i,j), myVarx(i,j), myR(i,j), wind, a);
+			for(int h=0;h<3;++h)
+			{
+				myEx[h](i,j) = a[h];
+				myMx[h](i,j) = (h==1 ? V(1.0) : V(0.0)) - theta*a[h];
+			}
+			calcRow(myDyd, myDy, myDyu, myDyy, j, dt, myMuy(i,j), myVary(i,j), myR(i,j), wind, a);
+			for(int h=0;h<3;++h)
+			{
+				myEy[h](i,j) = a[h];
+				myMy[h](j,i) = (h==1 ? V(1.0) : V(0.0)) - theta*a[h];
+			}
+		}
+	});
+
+	//	factor in column blocks
+	forTasks((ny + block - 1) / block, [&](int b)
+	{
+		kMatrixAlgebra::tridagFactorLines<V>(myMx[0], myMx[1], myMx[2], myBetix, myGamx, b*block, min(ny, (b+1)*block));
+	});
+	forTasks((nx + block - 1) / block, [&](int b)
+	{
+		kMatrixAlgebra::tridagFactorLines<V>(myMy[0], myMy[1], myMy[2], myBetiy, myGamy, b*block, min(nx, (b+1)*block));
+	});
+
+	//	record
+	myDtc	 = dt;
+	myThetac = theta;
+	myWindc	 = wind;
+
+	//	done
+	return;
+}
+
+//	transpose in tiles
+template <class V>
+void
+kFd2d<V>::transpose(
+	const kMatrix<V>&	A,
+	kMatrix<V>&			B)
+{
+	//	dims
+	const int tile = 32;
+	int n = A.rows();
+	int m = A.cols();
+	B.resize(m, n);
+
+	//	row tiles of A
+	forTasks((n + tile - 1) / tile, [&](int t)
+	{
+		int il = t*tile, iu = min(n, il+tile);
+		for(int jl=0;jl<m;jl+=tile)
+		{
+			int ju = min(m, jl+tile);
+			for(int i=il;i<iu;++i)
+			{
+				const V* a = &A(i,0);
+				for(int j=jl;j<ju;++j) B(j,i) = a[j];
+			}
+		}
+	});
+
+	//	done
+	return;
+}
+
+//	x operator
+template <class V>
+void
+kFd2d<V>::applyX(
+	const kMatrix<V>&	B,
+	kMatrix<V>&			X)
+{
+	int nx = myX.size();
+	int ny = myY.size();
+	X.resize(nx, ny);
+	forTasks(nx, [&](int i)
+	{
+		//	the boundary rows have zero weight outside the grid
+		const V* b	= &B(i,0);
+		const V* bl = i>0	 ? &B(i-1,0) : b;
+		const V* bu = i<nx-1 ? &B(i+1,0) : b;
+		const V* e0 = &myEx[0](i,0);
+		const V* e1 = &myEx[1](i,0);
+		const V* e2 = &myEx[2](i,0);
+		V*		 x	= &X(i,0);
+		for(int j=0;j<ny;++j) x[j] = e0[j]*bl[j] + e1[j]*b[j] + e2[j]*bu[j];
+	});
+
+	//	done
+	return;
+}
+
+//	y operator
+template <class V>
+void
+kFd2d<V>::applyY(
+	const kMatrix<V>&	B,
+	kMatrix<V>&			X)
+{
+	int nx = myX.size();
+	int ny = myY.size();
+	X.resize(nx, ny);
+	forTasks(nx, [&](int i)
+	{
+		const V* b	= &B(i,0);
+		const V* e0 = &myEy[0](i,0);
+		const V* e1 = &myEy[1](i,0);
+		const V* e2 = &myEy[2](i,0);
+		V*		 x	= &X(i,0);
+		x[0] = e1[0]*b[0] + (ny>1 ? e2[0]*b[1] : V(0.0));
+		for(int j=1;j<ny-1;++j) x[j] = e0[j]*b[j-1] + e1[j]*b[j] + e2[j]*b[j+1];
+		if(ny>1) x[ny-1] = e0[ny-1]*b[ny-2] + e1[ny-1]*b[ny-1];
+	});
+
+	//	done
+	return;
+}
+
+//	mixed operator
+template <class V>
+void
+kFd2d<V>::applyXY(
+	const kMatrix<V>&	B,
+	kMatrix<V>&			X)
+{
+	int nx = myX.size();
+	int ny = myY.size();
+	X.resize(nx, ny);
+	V dt = myDtc;
+	forTasks(nx, [&](int i)
+	{
+		V* x = &X(i,0);
+		for(int j=0;j<ny;++j) x[j] = 0.0;
+
+		//	rows i-1, i, i+1 with weights dx(i, .)
+		for(int a=0;a<3;++a)
+		{
+			int ia = i + a - 1;
+			V	wa = myDx(i,a);
+			if(ia<0 || ia>=nx || wa==0.0) continue;
+			const V* b = &B(ia,0);
+			x[0] += wa*(myDy(0,1)*b[0] + (ny>1 ? myDy(0,2)*b[1] : V(0.0)));
+			for(int j=1;j<ny-1;++j)
+			{
+				x[j] += wa*(myDy(j,0)*b[j-1] + myDy(j,1)*b[j] + myDy(j,2)*b[j+1]);
+			}
+			if(ny>1) x[ny-1] += wa*(myDy(ny-1,0)*b[ny-2] + myDy(ny-1,1)*b[ny-1]);
+		}
+		const V* c = &myCov(i,0);
+		for(int j=0;j<ny;++j) x[j] *= dt*c[j];
+	});
+
+	//	done
+	return;
+}
+
+//	sweeps
+template <class V>
+void
+kFd2d<V>::sweeps(
+	V					theta,
+	const kMatrix<V>&	Wx,
+	const kMatrix<V>&	Wy,
+	kMatrix<V>&			Y)
+{
+	int i, n = Y.size();
+	int nx = myX.size();
+	int ny = myY.size();
+
+	//	x lines in place
+	for(i=0;i<n;++i) Y[i] -= theta*Wx[i];
+	forTasks((ny + block - 1) / block, [&](int b)
+	{
+		kMatrixAlgebra::tridagSolveLines<V>(myMx[0], myBetix, myGamx, Y, Y, b*block, min(ny, (b+1)*block));
+	});
+
+	//	y lines transposed
+	for(i=0;i<n;++i) Y[i] -= theta*Wy[i];
+	transpose(Y, myTt);
+	forTasks((nx + block - 1) / block, [&](int b)
+	{
+		kMatrixAlgebra::tridagSolveLines<V>(myMy[0], myBetiy, myGamy, myTt, myTt, b*block, min(nx, (b+1)*block));
+	});
+	transpose(myTt, Y);
+
+	//	done
+	return;
+}
+
+//	roll bwd
+template <class V>
+void
+kFd2d<V>::rollBwd(
+	V						dt,
+	bool					update,
+	V						theta,
+	int						wind,
+	Scheme					scheme)
+{
+	//	helps
+	int i;
+
+	//	dims
+	int n = myRes.size();
+	if(!n) return;
+
+	//	operators
+	if(update || dt!=myDtc || theta!=myThetac || wind!=myWindc) buildOp(dt, theta, wind);
+
+	//	explicit products of U
+	kMatrix<V>& U = myRes;
+	applyX(U, myF1);
+	applyY(U, myF2);
+	applyXY(U, myF0);
+
+	//	Y0 = U + dt A U
+	for(i=0;i<n;++i) myY0[i] = U[i] + myF0[i] + myF1[i] + myF2[i];
+
+	//	douglas: Y2 into the results
+	kMatrix<V>& Y = scheme==douglas ? U : myYs;
+	for(i=0;i<n;++i) Y[i] = myY0[i];
+	sweeps(theta, myF1, myF2, Y);
+	if(scheme==douglas) return;
+
+	//	corrector weights
+	V c0 = scheme==craigSneyd ? V(0.5) : scheme==modifiedCraigSneyd ? theta : V(0.0);
+	V c	 = scheme==craigSneyd ? V(0.0) : scheme==modifiedCraigSneyd ? V(0.5)-theta : V(0.5);
+
+	//	explicit products of Y2
+	applyXY(Y, myG0);
+	if(c!=0.0 || scheme==hundsdorferVerwer)
+	{
+		applyX(Y, myG1);
+		applyY(Y, myG2);
+	}
+
+	//	Z0
+	for(i=0;i<n;++i)
+	{
+		V z = myY0[i] + c0*(myG0[i] - myF0[i]);
+		if(c!=0.0) z += c*(myG0[i] + myG1[i] + myG2[i] - myF0[i] - myF1[i] - myF2[i]);
+		U[i] = z;
+	}
+
+	//	sweeps around U or Y2
+	if(scheme==hundsdorferVerwer)	sweeps(theta, myG1, myG2, U);
+	else							sweeps(theta, myF1, myF2, U);
+
+	//	done
+	return;
+}
@@ -0,0 +1,217 @@
+#include "kFdChain.h"
+#include "kBlack.h"
+#include "kFd1d.h"
+#include <numeric>
+
+//	steps per expiry interval
+void
+kFdChain::steps(
+	const kVector<double>&	expiries,
+	const int				numt,
+	kVector<int>&			numSteps)
+{
+	//	dims
+	int numE = expiries.size();
+	numSteps.assign(numE, 0);
+	if(!numE) return;
+
+	//	about numt steps over the last expiry
+	double tMax = max(0.0, expiries(numE-1));
+	double tPrev = 0.0;
+	for(int e=0;e<numE;++e)
+	{
+		double t = max(tPrev, expiries(e));
+		if(t>tPrev) numSteps(e) = max(1, (int)std::lround(max(1, numt) * (t - tPrev) / tMax));
+		tPrev = t;
+	}
+
+	//	done
+	return;
+}
+
+//	prices of all strikes against the weights q
+void
+kFdChain::integrate(
+	const kVector<double>&	s,
+	const kMatrix<double>&	q,
+	const kVector<double>&	strikes,
+	const bool				dig,
+	const int				pc,
+	const int				smooth,
+	kMatrix<double>&		res)
+{
+	//	helps
+	int e, i, k;
+
+	//	dims
+	int n	 = s.size();
+	int numE = q.rows();
+	int numK = strikes.size();
+
+	//	payoffs, n x numK so the strikes are inner
+	kMatrix<double> payoff(n, numK);
+	kVector<double> f;
+	for(k=0;k<numK;++k)
+	{
+		kFiniteDifference::vanillaPayoff(s, strikes(k), dig, pc, smooth, f);
+		for(i=0;i<n;++i) payoff(i,k) = f(i);
+	}
+
+	//	res = q payoff, nodes without weight skipped
+	res.resize(numE, numK);
+	res = 0.0;
+	for(e=0;e<numE;++e)
+	{
+		double* re = &res(e,0);
+		for(i=0;i<n;++i)
+		{
+			double qi = q(e,i);
+			if(qi==0.0) continue;
+			const double* pi = &payoff(i,0);
+			for(k=0;k<numK;++k) re[k] += qi * pi[k];
+		}
+	}
+
+	//	done
+	return;
+}
+
+//	chain on fd
+bool
+kFdChain::price(
+	kFd1d<double,kGridGeneral>&	fd,
+	const int				i0,
+	const kVector<double>&	expiries,
+	const kVector<double>&	strikes,
+	const bool				dig,
+	const int				pc,
+	const int				smooth,
+	const double			theta,
+	const int				wind,
+	const int				numt,
+	const int				numRan,
+	kMatrix<double>&		res,
+	string&					error,
+	kMatrix<double>*		q)
+{
+	//	helps
+	int e, h, i, k;
+
+	//	dims
+	int n	 = fd.x().size();
+	int numE = expiries.size();
+	if(i0<0 || i0>=n || fd.res().numX()!=n || fd.res().numV()<1)
+	{
+		error = "kFdChain::price(): fd not initialized or start node off the grid";
+		return false;
+	}
+
+	//	expiries ascending
+	kVector<int> order(numE);
+	std::iota(order.data().begin(), order.data().end(), 0);
+	std::stable_sort(order.data().begin(), order.data().end(), [&](int a, int b) { return expiries(a)<expiries(b); });
+	kVector<double> t(numE);
+	for(e=0;e<numE;++e) t(e) = max(0.0, expiries(order(e)));
+	kVector<int> numSteps;
+	steps(t, numt, numSteps);
+
+	//	weights of node i0
+	kVector<double> w(n, 0.0);
+	w(i0) = 1.0;
+	fd.res().setSlot(0, w);
+
+	//	roll fwd, snapshot at every expiry
+	kMatrix<double> qs(numE, n);
+	double tPrev = 0.0, dtc = -1.0, thetac = -1.0;
+	int ran = 0;
+	for(e=0;e<numE;++e)
+	{
+		double dt = numSteps(e) ? (t(e) - tPrev) / numSteps(e) : 0.0;
+		for(h=0;h<numSteps(e);++h)
+		{
+			bool half = ran<numRan;
+			double dth = half ? 0.5*dt : dt;
+			double th  = half ? 1.0 : theta;
+			for(k=0;k<(half ? 2 : 1);++k)
+			{
+				fd.rollFwd(dth, dth!=dtc || th!=thetac, th, wind, fd.res());
+				dtc	   = dth;
+				thetac = th;
+			}
+			if(half) ++ran;
+		}
+		tPrev = t(e);
+		fd.res().getSlot(0, w);
+		for(i=0;i<n;++i) qs(e,i) = w(i);
+	}
+
+	//	payoffs on the s axis
+	kVector<double> s = fd.x();
+	if(fd.isLog())
+	{
+		for(i=0;i<n;++i) s(i) = exp(s(i));
+	}
+	kMatrix<double> rs;
+	integrate(s, qs, strikes, dig, pc, smooth, rs);
+
+	//	back to input order
+	int numK = strikes.size();
+	res.resize(numE, numK);
+	if(q) q->resize(numE, n);
+	for(e=0;e<numE;++e)
+	{
+		for(k=0;k<numK;++k) res(order(e),k) = rs(e,k);
+		if(q)
+		{
+			for(i=0;i<n;++i) (*q)(order(e),i) = qs(e,i);
+		}
+	}
+
+	//	done
+	return true;
+}
+
+//	black chain
+bool
+kFdChain::blackChain(
+	const double			s0,
+	const double			r,
+	const double			mu,
+	const double			sigma,
+	const kVector<double>&	expiries,
+	const kVector<double>&	strikes,
+	const bool				dig,
+	const int				pc,
+	const int				smooth,
+	const double			theta,
+	const int				wind,
+	const double			numStd,
+	const int				numt,
+	const int				numx,
+	const int				numRan,
+	kMatrix<double>&		res,
+	string&					error)
+{
+	//	helps
+	int i;
+
+	//	grid over the last expiry
+	double tMax = 0.0;
+	for(i=0;i<expiries.size();++i) tMax = max(tMax, expiries(i));
+	kVector<double> s;
+	kBlack::fdGrid(s0, sigma, tMax, numStd, numx, s);
+	int nums = s.size();
+
+	//	fd grid and parameters
+	kFd1d<double> fd;
+	fd.init(1, s, false);
+	for(i=0;i<nums;++i)
+	{
+		fd.r()(i)	= r;
+		fd.mu()(i)	= mu * s(i);
+		fd.var()(i) = kInlines::sqr(sigma * s(i));
+	}
+
+	//	done
+	return price(fd, nums/2, expiries, strikes, dig, pc, smooth, theta, wind, numt, numRan, res, error);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+//	desc:	strike/expiry chains from one forward solve
+//
+//	the arrow-debreu weights q of the start node are rolled fwd with the
+//	transposed operator of kFd1d::rollFwd and snapshot at every expiry. a
+//	payoff f on the grid is then worth q f, all strikes of an expiry in one
+//	pass over the snapshot. the fwd step is the transpose of the bwd step, so
+//	q f equals the bwd price at the start node on the same grid and time
+//	steps up to rounding, and the chain agrees with single bwd solves to
+//	discretization accuracy
+//
+//	the time steps are about the last expiry over numt, at least one per
+//	expiry interval. the first numRan steps are replaced by two implicit
+//	half steps each, which damps the crank-nicolson oscillations of the
+//	point mass start
+
+//	includes
+#include "kVector.h"
+#include "kMatrix.h"
+#include <string>
+
+using std::string;
+
+//	forward declaration
+struct kGridGeneral;
+template <class V, class G> class kFd1d;
+
+class kFdChain
+{
+public:
+
+	//	steps per expiry interval, expiries ascending, zero for empty intervals
+	static void	steps(
+		const kVector<double>&	expiries,
+		const int				numt,
+		kVector<int>&			numSteps);
+
+	//	prices of all strikes against the weights q (numE x n) on grid s into
+	//	res (numE x numK), payoffs as kFiniteDifference::vanillaPayoff
+	static void	integrate(
+		const kVector<double>&	s,
+		const kMatrix<double>&	q,
+		const kVector<double>&	strikes,
+		const bool				dig,
+		const int				pc,			//	put (-1) call (1)
+		const int				smooth,		//	smoothing
+		kMatrix<double>&		res);
+
+	//	chain on fd with the grid and coefficients set, weights from node i0,
+	//	expiries in any order, res is numE x numK, q the snapshots if asked for
+	static bool	price(
+		kFd1d<double,kGridGeneral>&	fd,
+		const int				i0,
+		const kVector<double>&	expiries,
+		const kVector<double>&	strikes,
+		const bool				dig,
+		const int				pc,			//	put (-1) call (1)
+		const int				smooth,		//	smoothing
+		const double			theta,
+		const int				wind,
+		const int				numt,
+		const int				numRan,		//	rannacher steps
+		kMatrix<double>&		res,
+		string&					error,
+		kMatrix<double>*		q = nullptr);	//	numE x n weights at the expiries
+
+	//	black chain: grid of kBlack::fdGrid spanning the last expiry, s0 on
+	//	the middle node
+	static bool	blackChain(
+		const double			s0,
+		const double			r,
+		const double			mu,
+		const double			sigma,
+		const kVector<double>&	expiries,
+		const kVector<double>&	strikes,
+		const bool				dig,
+		const int				pc,			//	put (-1) call (1)
+		const int				smooth,		//	smoothing
+		const double			theta,
+		const int				wind,
+		const double			numStd,
+		const int				numt,
+		const int				numx,
+		const int				numRan,		//	rannacher steps
+		kMatrix<double>&		res,
+		string&					error);
+};
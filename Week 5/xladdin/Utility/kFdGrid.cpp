@@ -0,0 +1,163 @@
+#include "kFdGrid.h"
+#include <cmath>
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+//	mapped coordinate
+double
+kFdGrid::map(
+	const kVector<double>&	centers,
+	const double			alpha,
+	const double			x,
+	double*					dydx)
+{
+	double y = 0.0, d = 0.0, z;
+	for(int k=0;k<centers.size();++k)
+	{
+		z  = (x - centers(k)) / alpha;
+		y += asinh(z);
+		d += 1.0 / (alpha * sqrt(1.0 + z*z));
+	}
+	if(dydx) *dydx = d;
+
+	//	done
+	return y;
+}
+
+//	inverse of map, newton safeguarded by bisection
+double
+kFdGrid::inverse(
+	const kVector<double>&	centers,
+	const double			alpha,
+	const double			y,
+	double					xl,
+	double					xu)
+{
+	double x = 0.5 * (xl + xu), f, d;
+	for(int it=0;it<100;++it)
+	{
+		f = map(centers, alpha, x, &d) - y;
+		if(f==0.0) break;
+		if(f>0.0)	xu = x;
+		else		xl = x;
+
+		double xn = x - f/d;
+		if(xn<=xl || xn>=xu) xn = 0.5 * (xl + xu);
+		if(fabs(xn - x)<=1.0e-15 * max(1.0, fabs(x))) { x = xn; break; }
+		x = xn;
+	}
+
+	//	done
+	return x;
+}
+
+//	concentrated grid
+bool
+kFdGrid::concentrated(
+	const double			xl,
+	const double			xu,
+	const int				n,
+	const kVector<double>&	points,
+	const kVector<int>&		snap,
+	const double			alpha,
+	kVector<double>&		x,
+	string&					error)
+{
+	//	check
+	if(n<2 || !(xu>xl) || !(alpha>0.0) || points.empty() || snap.size()!=points.size())
+	{
+		error = "kFdGrid::concentrated: need n >= 2, xu > xl, alpha > 0 and a snap for every point";
+		return false;
+	}
+
+	//	helps
+	int i, j, k;
+
+	//	anchors: position in index space and point, ends first
+	double yl = map(points, alpha, xl);
+	double yu = map(points, alpha, xu);
+	kVector<double> ai, ax;
+	ai.push_back(0.0);		ax.push_back(xl);
+	ai.push_back(n);		ax.push_back(xu);
+
+	//	snap points in order of priority
+	int numP = points.size();
+	for(k=0;k<numP;++k)
+	{
+		double p = points(k);
+		if(snap(k)==none || !(p>xl && p<xu)) continue;
+
+		//	nearest node or midpoint, away from the ends
+		bool   mid = snap(k)==kFdGrid::mid;
+		double u   = n * (map(points, alpha, p) - yl) / (yu - yl);
+		double a   = mid ? floor(u) + 0.5 : floor(u + 0.5);
+		if(a<(mid ? 1.5 : 1.0) || a>n-(mid ? 1.5 : 1.0)) continue;
+
+		//	no node moved by two anchors: a full interval off the other anchors,
+		//	two between midpoints which each move the nodes on either side
+		bool ok = true;
+		for(j=0;ok && j<ai.size();++j) ok = fabs(a - ai(j))>=(mid && ai(j)!=floor(ai(j)) ? 2.0 : 1.0);
+		if(!ok) continue;
+
+		ai.push_back(a);
+		ax.push_back(p);
+	}
+
+	//	sort anchors
+	int numA = ai.size();
+	kVector<int> order(numA);
+	for(j=0;j<numA;++j) order(j) = j;
+	std::sort(order.data().begin(), order.data().end(), [&](int a, int b) { return ai(a)<ai(b); });
+
+	//	nodes: mapped coordinate linear in the index between anchors
+	x.resize(n+1);
+	for(j=0;j<numA-1;++j)
+	{
+		double il = ai(order(j)), iu = ai(order(j+1));
+		double ql = map(points, alpha, ax(order(j)));
+		double qu = map(points, alpha, ax(order(j+1)));
+		for(i=(int)ceil(il);i<=(int)floor(iu);++i)
+		{
+			x(i) = inverse(points, alpha, ql + (qu - ql) * (i - il) / (iu - il), xl, xu);
+		}
+	}
+
+	//	exact nodes, and midpoints by moving the two nodes around them
+	for(j=0;j<numA;++j)
+	{
+		double a = ai(j), p = ax(j);
+		i = (int)floor(a);
+		if(a==i)
+		{
+			x(i) = p;
+		}
+		else
+		{
+			double h = x(i+1) - x(i);
+			x(i)	 = p - 0.5*h;
+			x(i+1)	 = p + 0.5*h;
+		}
+	}
+
+	//	done
+	return true;
+}
+
+//	index of closest node
+int
+kFdGrid::index(
+	const kVector<double>&	x,
+	const double			p)
+{
+	int n = x.size();
+	if(n==0) return -1;
+
+	int i = (int)(std::lower_bound(x.data().begin(), x.data().end(), p) - x.data().begin());
+	if(i>=n) return n-1;
+	if(i>0 && p - x(i-1) < x(i) - p) --i;
+
+	//	done
+	return i;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+//	desc:	non uniform fd grids concentrated around points of interest
+//
+//	the nodes are equally spaced in the mapped coordinate
+//
+//		y(x) = sum_k asinh((x - p(k)) / alpha)
+//
+//	so the spacing is about alpha / n at a single point and grows linearly
+//	with the distance to it. the map is then adjusted piecewise so that the
+//	snapped points are hit exactly: on a node, or on the midpoint of two nodes
+//	(x(i) + x(i+1)) / 2. the adjustment changes the spacing by at most half an
+//	interval over the distance between two snapped points, so the scheme keeps
+//	its order. points that would land on or next to an earlier one, or move a
+//	node it moves, are only concentrated around, so list the most important first
+//
+
+//	includes
+#include "kVector.h"
+#include <string>
+
+using std::string;
+
+//	class declaration
+class kFdGrid
+{
+public:
+
+	//	snapping of a point
+	enum Snap
+	{
+		none,
+		node,
+		mid
+	};
+
+	//	grid x(0) = xl, ..., x(n) = xu concentrated around points with width alpha
+	static bool	concentrated(
+		const double			xl,
+		const double			xu,
+		const int				n,			//	number of intervals
+		const kVector<double>&	points,		//	by priority
+		const kVector<int>&		snap,		//	Snap of every point
+		const double			alpha,
+		kVector<double>&		x,
+		string&					error);
+
+	//	index of the node closest to p
+	static int	index(
+		const kVector<double>&	x,
+		const double			p);
+
+private:
+
+	//	mapped coordinate and its derivative
+	static double	map(
+		const kVector<double>&	centers,
+		const double			alpha,
+		const double			x,
+		double*					dydx = nullptr);
+
+	//	inverse of map on [xl, xu]
+	static double	inverse(
+		const kVector<double>&	centers,
+		const double			alpha,
+		const double			y,
+		double					xl,
+		double					xu);
+};
@@ -0,0 +1,279 @@
+#include "kFdLayers.h"
+#include "kFdSchedule.h"
+#include "kBlack.h"
+
+//	init
+void
+kFdLayers::init(
+	const kVector<double>&	s,
+	const kVector<double>&	a,
+	kThreadPool*			pool,
+	int						numChunks)
+{
+	//	helps
+	int c, k;
+
+	//	grid and layers
+	myS = s;
+	myA = a;
+	int n = s.size();
+	int m = a.size();
+	myR.resize(n, 0.0);
+	myMu.resize(n, 0.0);
+	myVar.resize(n, 0.0);
+
+	//	pool and blocks of about equal size
+	myPool = pool ? pool : &kThreadPool::global();
+	int numT = myPool->numThreads();
+	if(numChunks<=0) numChunks = numT;
+	numChunks = max(1, min(numChunks, m));
+	myFd.resize(numChunks);
+	myFirst.resize(numChunks+1);
+	myChunk.resize(m);
+	for(c=0;c<=numChunks;++c) myFirst(c) = (int)((long long)m*c/numChunks);
+	for(c=0;c<numChunks;++c)
+	{
+		myFd(c).init(myFirst(c+1) - myFirst(c), s, false);
+		for(k=myFirst(c);k<myFirst(c+1);++k) myChunk(k) = c;
+	}
+
+	//	remap workspace
+	myV.resize(numT);
+	myAq.resize(numT);
+	myOut.resize(numT);
+	myW.resize(numT);
+	myD.resize(numT);
+	myIl.resize(numT);
+	for(c=0;c<numT;++c)
+	{
+		myV(c).resize(m);
+		myAq(c).resize(m);
+	}
+
+	//	done
+	return;
+}
+
+//	roll bwd
+void
+kFdLayers::rollBwd(
+	double					dt,
+	bool					update,
+	double					theta,
+	int						wind)
+{
+	myPool->parallelFor(myFd.size(), [&](int c, int)
+	{
+		kFd1d<double>& fd = myFd(c);
+		if(update)
+		{
+			fd.r()	 = myR;
+			fd.mu()	 = myMu;
+			fd.var() = myVar;
+		}
+		fd.rollBwd(dt, update, theta, wind, fd.res());
+	});
+
+	//	done
+	return;
+}
+
+//	fixing
+void
+kFdLayers::fixing(
+	int						state,
+	double					w,
+	bool					cubic)
+{
+	//	dims
+	int n	 = myS.size();
+	int m	 = myA.size();
+	int numC = myFd.size();
+
+	//	node by node: gather the layers, interpolate at the new states, scatter
+	myPool->parallelFor(n, [&](int i, int t)
+	{
+		//	helps
+		int c, k;
+		kVector<double>& v	 = myV(t);
+		kVector<double>& aq	 = myAq(t);
+		kVector<double>& out = myOut(t);
+		double si = myS(i);
+
+		for(c=0;c<numC;++c)
+		{
+			kSlotMatrix<double>& res = myFd(c).res();
+			int k0 = myFirst(c);
+			for(k=k0;k<myFirst(c+1);++k) v(k) = res(k-k0,i);
+		}
+
+		switch(state)
+		{
+		case average:	for(k=0;k<m;++k) aq(k) = myA(k) + w * (si - myA(k)); break;
+		case maximum:	for(k=0;k<m;++k) aq(k) = max(myA(k), si); break;
+		default:		for(k=0;k<m;++k) aq(k) = min(myA(k), si); break;
+		}
+
+		if(cubic)	kFiniteDifference::monotoneInterpolate(myA, v, aq, out, myD(t));
+		else		kFiniteDifference::linearInterpolate(myA, v, aq, out, myIl(t), myW(t));
+
+		for(c=0;c<numC;++c)
+		{
+			kSlotMatrix<double>& res = myFd(c).res();
+			int k0 = myFirst(c);
+			for(k=k0;k<myFirst(c+1);++k) res(k-k0,i) = out(k);
+		}
+	});
+
+	//	done
+	return;
+}
+
+//	black runner
+bool
+kFdLayers::blackRunner(
+	const double			s0,
+	const double			r,
+	const double			mu,
+	const double			sigma,
+	const double			expiry,
+	const double			strike,
+	const int				pc,
+	const bool				floating,
+	const int				state,
+	const kVector<double>&	fixings,
+	const double			theta,
+	const int				wind,
+	const double			numStd,
+	const int				numt,
+	const int				numx,
+	const int				numa,
+	const int				numRan,
+	const bool				cubic,
+	const int				numThreads,
+	double&					res0,
+	string&					error)
+{
+	//	helps
+	int e, h, i, k;
+
+	//	checks
+	double t = max(0.0, expiry);
+	int numF = fixings.size();
+	if(numF<1 || numa<2)
+	{
+		error = "kFdLayers::blackRunner(): need fixings and at least 2 layers";
+		return false;
+	}
+	for(e=0;e<numF;++e)
+	{
+		if(fixings(e)<0.0 || fixings(e)>t || (e && fixings(e)<=fixings(e-1)))
+		{
+			error = "kFdLayers::blackRunner(): fixings must be ascending in [0, expiry]";
+			return false;
+		}
+	}
+
+	//	s axis, s0 on the middle node
+	kVector<double> s;
+	kBlack::fdGrid(s0, sigma, t, numStd, numx, s);
+	int n  = s.size();
+	int i0 = n / 2;
+
+	//	log equidistant layers over the range of the s grid: the average over all
+	//	of it, since after the early fixings it is close to s and spreads with
+	//	sigma sqrt(t), not only with its terminal std of about sigma sqrt(t / 3),
+	//	the maximum from s0 up and the minimum from s0 down
+	double sd = sigma * sqrt(t) * numStd;
+	double al, au;
+	switch(state)
+	{
+	case average:	al = -sd;	au = sd;	break;
+	case maximum:	al = 0.0;	au = sd;	break;
+	default:		al = -sd;	au = 0.0;	break;
+	}
+	if(au<=al) au = al + 1.0e-8;
+	kVector<double> a(numa);
+	for(k=0;k<numa;++k) a(k) = s0 * exp(al + (au - al) * k / (numa - 1));
+
+	//	pool
+	std::unique_ptr<kThreadPool> local;
+	if(numThreads>0) local.reset(new kThreadPool(numThreads));
+	kThreadPool& pool = local ? *local : kThreadPool::global();
+
+	//	layers and coefficients
+	kFdLayers fd;
+	fd.init(s, a, &pool);
+	for(i=0;i<n;++i)
+	{
+		fd.r()(i)	= r;
+		fd.mu()(i)	= mu * s(i);
+		fd.var()(i) = kInlines::sqr(sigma * s(i));
+	}
+
+	//	payoff
+	for(k=0;k<numa;++k)
+	{
+		for(i=0;i<n;++i)
+		{
+			double x = floating ? s(i) - a(k) : a(k) - strike;
+			fd(k,i) = max(0.0, pc * x);
+		}
+	}
+
+	//	time nodes with the fixings on nodes, fixing e on node(e)
+	kVector<kFdEvent> events(numF);
+	for(e=0;e<numF;++e) events(e).time = fixings(e);
+	kVector<double> times;
+	kFdSchedule::timeGrid(t, numt, events, times);
+	int N = times.size() - 1;
+	kVector<int> node(numF);
+	for(e=0;e<numF;++e)
+	{
+		h = (int)(std::lower_bound(times.data().begin(), times.data().end(), fixings(e)) - times.data().begin());
+		if(h>N) h = N;
+		if(h>0 && fixings(e) - times(h-1) < times(h) - fixings(e)) --h;
+		node(e) = h;
+	}
+
+	//	fixings on node h, latest first
+	int ran = numRan;
+	e = numF - 1;
+	auto atNode = [&](int h)
+	{
+		for(;e>=0 && node(e)==h;--e)
+		{
+			fd.fixing(state, 1.0 / (e + 1), cubic);
+			ran = numRan;
+		}
+	};
+
+	//	roll
+	atNode(N);
+	double dtc = -1.0, thetac = -1.0;
+	for(h=N-1;h>=0;--h)
+	{
+		double dt = times(h+1) - times(h);
+		bool half = ran>0;
+		double dth = half ? 0.5*dt : dt;
+		double th  = half ? 1.0 : theta;
+		for(k=0;k<(half ? 2 : 1);++k)
+		{
+			fd.rollBwd(dth, dth!=dtc || th!=thetac, th, wind);
+			dtc	   = dth;
+			thetac = th;
+		}
+		if(half) --ran;
+		atNode(h);
+	}
+
+	//	at the layer of s0, where the states start, interpolated for the average
+	//	whose start state does not matter once fixed
+	kVector<double> v(numa), aq(1, s0), out, d;
+	for(k=0;k<numa;++k) v(k) = fd(k,i0);
+	kFiniteDifference::monotoneInterpolate(a, v, aq, out, d);
+	res0 = out(0);
+
+	//	done
+	return true;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+//	desc:	state augmented fd for discretely monitored path dependents
+//
+//	V(t, s, a) carries a path state a, the running average, maximum or
+//	minimum of s over the fixings, on layers a(0) < ... < a(m-1). the state
+//	only changes at the fixings, so between them every layer solves the same
+//	1d pde in s: the layers are the result slots of kFd1d and roll together,
+//	sharing the operators and their factorization. at a fixing the state
+//	jumps and the layers are remapped node by node
+//
+//		V(t-, s, a) = V(t+, s, a')		a' = a + w (s - a), max(a, s), min(a, s)
+//
+//	with w = 1 / j at the j-th fixing for the average. a' is ascending in a,
+//	so the remap is one interpolation across the layers per node, linear or
+//	monotone cubic, flat beyond the outer layers
+//
+//	the layers are split into numChunks blocks of contiguous layers, one
+//	kFd1d per block. the blocks roll on the threads of a pool, the remap
+//	runs over the nodes on the same pool
+
+//	includes
+#include "kFd1d.h"
+#include "kThreadPool.h"
+#include <string>
+
+using std::string;
+
+//	class declaration
+class kFdLayers
+{
+public:
+
+	//	state
+	enum State
+	{
+		average,
+		maximum,
+		minimum
+	};
+
+	//	init on grid s (not log) with layers a ascending, null pool for the shared
+	//	one, numChunks <= 0 for one block per thread of the pool
+	void	init(
+		const kVector<double>&	s,
+		const kVector<double>&	a,
+		kThreadPool*			pool		= nullptr,
+		int						numChunks	= 0);
+
+	//	coefficients on grid s, shared by the layers
+	const kVector<double>&		r()		const { return myR; }
+	const kVector<double>&		mu()	const { return myMu; }
+	const kVector<double>&		var()	const { return myVar; }
+	const kVector<double>&		s()		const { return myS; }
+	const kVector<double>&		a()		const { return myA; }
+
+	kVector<double>&			r()		{ return myR; }
+	kVector<double>&			mu()	{ return myMu; }
+	kVector<double>&			var()	{ return myVar; }
+
+	//	result on layer k, node i
+	double		operator()(int k, int i) const { return myFd(myChunk(k)).res()(k - myFirst(myChunk(k)), i); }
+	double&		operator()(int k, int i) { return myFd(myChunk(k)).res()(k - myFirst(myChunk(k)), i); }
+
+	//	blocks
+	int							numChunks() const { return myFd.size(); }
+
+	//	roll all layers bwd, update takes the coefficients and rebuilds the operators
+	void	rollBwd(
+		double					dt,
+		bool					update,
+		double					theta,
+		int						wind);
+
+	//	fixing of state with weight w (average only)
+	void	fixing(
+		int						state,
+		double					w,
+		bool					cubic);
+
+	//	black runner for average (asian) and maximum / minimum (lookback)
+	//	options on the state at the fixing times, fixed strike pays
+	//	max(pc (a - strike), 0), floating strike max(pc (s - a), 0)
+	static bool	blackRunner(
+		const double			s0,
+		const double			r,
+		const double			mu,
+		const double			sigma,
+		const double			expiry,
+		const double			strike,
+		const int				pc,			//	put (-1) call (1)
+		const bool				floating,	//	floating strike
+		const int				state,		//	State
+		const kVector<double>&	fixings,	//	fixing times in [0, expiry]
+		const double			theta,
+		const int				wind,
+		const double			numStd,
+		const int				numt,
+		const int				numx,
+		const int				numa,		//	number of layers
+		const int				numRan,		//	rannacher steps after the start and the fixings
+		const bool				cubic,		//	monotone cubic remap, linear otherwise
+		const int				numThreads,	//	<= 0 uses the shared pool
+		double&					res0,
+		string&					error);
+
+private:
+
+	//	grid, layers and coefficients
+	kVector<double>				myS, myA;
+	kVector<double>				myR, myMu, myVar;
+
+	//	blocks of layers: kFd1d, first layer, block of every layer
+	kVector<kFd1d<double>>		myFd;
+	kVector<int>				myFirst;
+	kVector<int>				myChunk;
+
+	//	pool
+	kThreadPool*				myPool{nullptr};
+
+	//	per thread remap workspace
+	kVector<kVector<double>>	myV, myAq, myOut, myW, myD;
+	kVector<kVector<int>>		myIl;
+};
@@ -0,0 +1,120 @@
+#include "kFdPortfolio.h"
+#include "kThreadPool.h"
+#include "kBachelier.h"
+#include "kBlack.h"
+#include "kFd1d.h"
+#include <memory>
+
+//	estimated cost
+double
+kFdPortfolio::cost(
+	const kFdTrade&	trade)
+{
+	double res = (double)max(1, trade.numt) * (double)max(1, trade.numx);
+	if(trade.ea>0) res *= 1.25;
+
+	//	done
+	return res;
+}
+
+//	price trades
+bool
+kFdPortfolio::price(
+	const kVector<kFdTrade>&	trades,
+	int							numThreads,
+	kVector<double>&			res0,
+	string&						error)
+{
+	//	helps
+	int c, i;
+
+	//	dims
+	int numTr = trades.size();
+	res0.assign(numTr, 0.0);
+	if(!numTr) return true;
+
+	//	pool
+	std::unique_ptr<kThreadPool> local;
+	if(numThreads>0) local.reset(new kThreadPool(numThreads));
+	kThreadPool& pool = local ? *local : kThreadPool::global();
+	int numT = pool.numThreads();
+
+	//	sort by cost, heaviest first
+	kVector<double> costs(numTr);
+	kVector<int> order(numTr);
+	double total = 0.0;
+	for(i=0;i<numTr;++i)
+	{
+		costs(i) = cost(trades(i));
+		order(i) = i;
+		total	+= costs(i);
+	}
+	std::stable_sort(order.data().begin(), order.data().end(), [&](int a, int b) { return costs(a)>costs(b); });
+
+	//	chunks of about equal cost, several per thread so stealing can balance.
+	//	chunk c is order(first(c)) ... order(first(c+1)-1), every chunk but the
+	//	last costs at least target, so there are at most 8 numT + 1
+	double target = total / (8.0 * numT);
+	int maxC = 8 * numT + 1;
+	kVector<int> first;
+	first.reserve(maxC + 1);
+	double chunkCost = 0.0;
+	for(i=0;i<numTr;++i)
+	{
+		if(first.empty() || chunkCost>=target)
+		{
+			first.push_back(i);
+			chunkCost = 0.0;
+		}
+		chunkCost += costs(order(i));
+	}
+	int numC = first.size();
+	first.push_back(numTr);
+
+	//	deal chunks round robin, heaviest first in every queue
+	kVector<kVector<int>> queues(numT);
+	for(c=0;c<numT;++c) queues(c).reserve((maxC + numT - 1) / numT);
+	for(c=0;c<numC;++c) queues(c % numT).push_back(c);
+
+	//	per thread workspaces, bachelier grids are uniform
+	kVector<kFd1d<double>> fds(numT);
+	kVector<kFd1d<double,kGridUniform>> fdus(numT);
+	kVector<kVector<double>> ss(numT), ress(numT);
+	kVector<string> errs(numTr);
+	kVector<int> ok(numTr, 1);
+
+	//	run
+	pool.run(queues, [&](int ch, int t)
+	{
+		for(int k=first(ch);k<first(ch+1);++k)
+		{
+			int l = order(k);
+			const kFdTrade& tr = trades(l);
+			bool succ;
+			if(tr.model>0)
+			{
+				succ = kBlack::fdRunner(tr.s0, tr.r, tr.mu, tr.sigma, tr.expiry, tr.strike, tr.dig, tr.pc, tr.ea, tr.smooth,
+					tr.theta, tr.wind, tr.numStd, tr.numt, tr.numx, true, 1, fds(t), res0(l), ss(t), ress(t), errs(l));
+			}
+			else
+			{
+				succ = kBachelier::fdRunner(tr.s0, tr.r, tr.mu, tr.sigma, tr.expiry, tr.strike, tr.dig, tr.pc, tr.ea, tr.smooth,
+					tr.theta, tr.wind, tr.numStd, tr.numt, tr.numx, true, 1, fdus(t), res0(l), ss(t), ress(t), errs(l));
+			}
+			if(!succ) ok(l) = 0;
+		}
+	});
+
+	//	report first failure
+	for(i=0;i<numTr;++i)
+	{
+		if(!ok(i))
+		{
+			error = "kFdPortfolio::price(): trade " + std::to_string(i) + " failed: " + errs(i);
+			return false;
+		}
+	}
+
+	//	done
+	return true;
+}
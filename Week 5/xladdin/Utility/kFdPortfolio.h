@@ -0,0 +1,60 @@
+#pragma once
+
+//	desc:	portfolio pricing with the fd runners on a work stealing thread pool
+//
+//	trades are sorted by estimated cost (numt x numx), grouped into chunks of
+//	roughly equal cost and dealt to the threads heaviest first, idle threads
+//	steal the remaining chunks. every thread reuses its own kFd1d workspaces.
+//	results are returned in input order
+
+//	includes
+#include "kVector.h"
+#include <string>
+
+using std::string;
+
+//	trade spec, same parameters as fdRunner
+struct kFdTrade
+{
+	//	model: bachelier (0), black (1)
+	int		model	= 1;
+
+	//	params
+	double	s0		= 0.0;
+	double	r		= 0.0;
+	double	mu		= 0.0;
+	double	sigma	= 0.1;
+
+	//	contract
+	double	expiry	= 0.0;
+	double	strike	= 0.0;
+	bool	dig		= false;
+	int		pc		= 1;		//	put (-1) call (1)
+	int		ea		= 0;		//	european (0), american (1: projection, 2: brennan-schwartz, 3: penalty)
+	int		smooth	= 0;
+
+	//	grid tech
+	double	theta	= 0.5;
+	int		wind	= 0;
+	double	numStd	= 5.0;
+	int		numt	= 25;
+	int		numx	= 50;
+};
+
+//	class
+class kFdPortfolio
+{
+public:
+
+	//	estimated cost of a trade
+	static double	cost(
+		const kFdTrade&				trade);
+
+	//	price trades, numThreads <= 0 uses the shared pool
+	static bool		price(
+		const kVector<kFdTrade>&	trades,
+		int							numThreads,
+		kVector<double>&			res0,
+		string&						error);
+
+};
@@ -0,0 +1,254 @@
+#include "kFdSchedule.h"
+#include "kBlack.h"
+#include "kFd1d.h"
+#include "kFdGrid.h"
+
+//	time nodes
+void
+kFdSchedule::timeGrid(
+	const double				expiry,
+	const int					numt,
+	const kVector<kFdEvent>&	events,
+	kVector<double>&			times)
+{
+	//	helps
+	int e, h;
+
+	//	dates strictly inside, ascending and apart
+	double t   = max(0.0, expiry);
+	double tol = 1.0e-10 * max(1.0, t);
+	kVector<double> dates;
+	dates.push_back(0.0);
+	for(e=0;e<events.size();++e)
+	{
+		if(events(e).time>tol && events(e).time<t-tol) dates.push_back(events(e).time);
+	}
+	std::sort(dates.data().begin(), dates.data().end());
+	dates.push_back(t);
+
+	//	equal steps of at most about t / numt between dates
+	double dtMax = t / max(1, numt);
+	times.resize(0);
+	times.push_back(0.0);
+	for(e=1;e<dates.size();++e)
+	{
+		double a = times(times.size()-1);
+		double b = dates(e);
+		if(b-a<=tol) continue;
+		int m = max(1, (int)ceil((b - a) / dtMax - 1.0e-9));
+		for(h=1;h<m;++h) times.push_back(a + (b - a) * h / m);
+		times.push_back(b);
+	}
+
+	//	done
+	return;
+}
+
+//	apply event
+void
+kFdSchedule::apply(
+	const kFdEvent&				event,
+	const kVector<double>&		s,
+	const kVector<double>*		exercise,
+	kSlotMatrix<double>&		res)
+{
+	//	helps
+	int i, k;
+
+	//	dims
+	int n	 = s.size();
+	int numV = res.numV();
+
+	switch(event.type)
+	{
+	case kFdEvent::knockOutUp:
+		for(i=0;i<n;++i)
+		{
+			if(s(i)<event.level) continue;
+			for(k=0;k<numV;++k) res(k,i) = event.rebate;
+		}
+		break;
+
+	case kFdEvent::knockOutDown:
+		for(i=0;i<n;++i)
+		{
+			if(s(i)>event.level) continue;
+			for(k=0;k<numV;++k) res(k,i) = event.rebate;
+		}
+		break;
+
+	case kFdEvent::exercise:
+		if(!exercise) break;
+		for(k=0;k<numV;++k)
+		{
+			for(i=0;i<n;++i) res(k,i) = max(res(k,i), (*exercise)(i));
+		}
+		break;
+
+	case kFdEvent::dividend:
+	{
+		kVector<double> sd(n), v, vd, d;
+		for(i=0;i<n;++i) sd(i) = s(i) - event.level;
+		for(k=0;k<numV;++k)
+		{
+			res.getSlot(k, v);
+			kFiniteDifference::monotoneInterpolate(s, v, sd, vd, d);
+			res.setSlot(k, vd);
+		}
+		break;
+	}
+	}
+
+	//	done
+	return;
+}
+
+//	roll bwd with events
+void
+kFdSchedule::rollBwd(
+	kFd1d<double,kGridGeneral>&	fd,
+	const kVector<double>&		times,
+	const kVector<kFdEvent>&	events,
+	const double				theta,
+	const int					wind,
+	const int					numRan,
+	const kVector<double>*		exercise,
+	kSlotMatrix<double>&		res,
+	const Hook&					hook)
+{
+	//	helps
+	int e, h, k;
+
+	//	dims
+	int N	 = times.size() - 1;
+	int numE = events.size();
+	if(N<0) return;
+
+	//	time node of every event
+	kVector<int> node(numE);
+	for(e=0;e<numE;++e)
+	{
+		h = (int)(std::lower_bound(times.data().begin(), times.data().end(), events(e).time) - times.data().begin());
+		if(h>N) h = N;
+		if(h>0 && events(e).time - times(h-1) < times(h) - events(e).time) --h;
+		node(e) = h;
+	}
+
+	//	events of node h, rannacher steps to go after them
+	int ran = numRan;
+	auto atNode = [&](int h)
+	{
+		for(e=0;e<numE;++e)
+		{
+			if(node(e)!=h) continue;
+			apply(events(e), fd.x(), exercise, res);
+			if(events(e).type!=kFdEvent::exercise) ran = numRan;
+		}
+	};
+
+	//	roll
+	atNode(N);
+	double dtc = -1.0, thetac = -1.0;
+	for(h=N-1;h>=0;--h)
+	{
+		double dt = times(h+1) - times(h);
+		bool half = ran>0;
+		double dth = half ? 0.5*dt : dt;
+		double th  = half ? 1.0 : theta;
+		for(k=0;k<(half ? 2 : 1);++k)
+		{
+			fd.rollBwd(dth, dth!=dtc || th!=thetac, th, wind, res);
+			dtc	   = dth;
+			thetac = th;
+		}
+		if(half) --ran;
+		atNode(h);
+		if(hook) hook(h, times(h), res);
+	}
+
+	//	done
+	return;
+}
+
+//	black runner with events
+bool
+kFdSchedule::blackRunner(
+	const double				s0,
+	const double				r,
+	const double				mu,
+	const double				sigma,
+	const double				expiry,
+	const double				strike,
+	const bool					dig,
+	const int					pc,
+	const int					smooth,
+	const kVector<kFdEvent>&	events,
+	const double				theta,
+	const int					wind,
+	const double				numStd,
+	const int					numt,
+	const int					numx,
+	const int					numRan,
+	const double				conc,
+	double&						res0,
+	string&						error)
+{
+	//	helps
+	int e, i, i0;
+
+	//	s axis, concentrated around s0, the strike and the barriers
+	double t   = max(0.0, expiry);
+	double sd  = sigma * sqrt(t);
+	int nums   = 2 * (numx / 2);
+	kVector<double> s;
+	if(conc<=0.0 || nums<2 || sd<=0.0)
+	{
+		kBlack::fdGrid(s0, sigma, t, numStd, numx, s);
+		i0 = s.size() / 2;
+	}
+	else
+	{
+		kVector<double> points;
+		kVector<int> snap;
+		points.push_back(s0);
+		snap.push_back(kFdGrid::node);
+		points.push_back(strike);
+		snap.push_back(dig ? kFdGrid::mid : kFdGrid::node);
+		for(e=0;e<events.size();++e)
+		{
+			if(events(e).type==kFdEvent::knockOutUp || events(e).type==kFdEvent::knockOutDown)
+			{
+				points.push_back(events(e).level);
+				snap.push_back(kFdGrid::mid);
+			}
+		}
+		if(!kFdGrid::concentrated(s0 * exp(-numStd * sd), s0 * exp(numStd * sd), nums,
+			points, snap, conc * s0 * sd, s, error)) return false;
+		i0 = kFdGrid::index(s, s0);
+	}
+	int n = s.size();
+
+	//	fd grid and parameters
+	kFd1d<double> fd;
+	fd.init(1, s, false);
+	for(i=0;i<n;++i)
+	{
+		fd.r()(i)	= r;
+		fd.mu()(i)	= mu * s(i);
+		fd.var()(i) = kInlines::sqr(sigma * s(i));
+	}
+
+	//	payoff, also the exercise values
+	kVector<double> payoff;
+	kFiniteDifference::vanillaPayoff(s, strike, dig, pc, smooth, payoff);
+	fd.res().setSlot(0, payoff);
+
+	//	roll
+	kVector<double> times;
+	timeGrid(t, numt, events, times);
+	rollBwd(fd, times, events, theta, wind, numRan, &payoff, fd.res());
+	res0 = fd.res()(0, i0);
+
+	//	done
+	return true;
+}
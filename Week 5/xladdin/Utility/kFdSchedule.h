@@ -0,0 +1,107 @@
+#pragma once
+
+//	desc:	event dates in the bwd roll of kFd1d
+//
+//	timeGrid merges the event dates into the step schedule: every date is a
+//	time node and the steps between two dates are equal and at most about
+//	expiry / numt, so a date only shortens the steps of its own interval and
+//	the number of steps grows by at most one per date. rollBwd takes the
+//	steps from the last time node to the first and applies the events of a
+//	date to all slots when the roll reaches it, then calls the hook if given:
+//
+//		knock out	the results beyond the barrier level are set to the rebate
+//		exercise	the results are floored at the exercise values
+//		dividend	a cash dividend paid at the date, V(t-, s) = V(t+, s - D) by
+//					monotone cubic interpolation, flat beyond the grid
+//
+//	knock outs and dividends leave kinks or jumps in the results, the first
+//	numRan steps after them (and after the start) are replaced by two
+//	implicit half steps each
+
+//	includes
+#include "kVector.h"
+#include "kSlotMatrix.h"
+#include <functional>
+#include <string>
+
+using std::string;
+
+//	forward declaration
+struct kGridGeneral;
+template <class V, class G> class kFd1d;
+
+//	event spec
+struct kFdEvent
+{
+	//	types
+	enum Type
+	{
+		knockOutUp,			//	knocked out at s >= level
+		knockOutDown,		//	knocked out at s <= level
+		exercise,			//	bermudan exercise
+		dividend			//	cash dividend of level
+	};
+
+	int		type	= exercise;
+	double	time	= 0.0;
+	double	level	= 0.0;
+	double	rebate	= 0.0;
+};
+
+class kFdSchedule
+{
+public:
+
+	//	hook after every step and its events: step h ends at times(h)
+	using Hook = std::function<void(int h, double t, kSlotMatrix<double>& res)>;
+
+	//	time nodes from 0 to expiry with the event dates in (0, expiry) on nodes
+	static void	timeGrid(
+		const double				expiry,
+		const int					numt,
+		const kVector<kFdEvent>&	events,
+		kVector<double>&			times);
+
+	//	apply event to all slots of res on grid s, exercise values on the grid for exercise events
+	static void	apply(
+		const kFdEvent&				event,
+		const kVector<double>&		s,
+		const kVector<double>*		exercise,
+		kSlotMatrix<double>&		res);
+
+	//	roll res bwd over times with fd, events on the nearest time node, those at
+	//	the last node before the first step
+	static void	rollBwd(
+		kFd1d<double,kGridGeneral>&	fd,
+		const kVector<double>&		times,
+		const kVector<kFdEvent>&	events,
+		const double				theta,
+		const int					wind,
+		const int					numRan,
+		const kVector<double>*		exercise,
+		kSlotMatrix<double>&		res,
+		const Hook&					hook = nullptr);
+
+	//	black runner with events, exercise values the vanilla payoff, conc > 0
+	//	concentrates the grid around s0, the strike and the barriers (midpoints)
+	static bool	blackRunner(
+		const double				s0,
+		const double				r,
+		const double				mu,
+		const double				sigma,
+		const double				expiry,
+		const double				strike,
+		const bool					dig,
+		const int					pc,			//	put (-1) call (1)
+		const int					smooth,		//	smoothing
+		const kVector<kFdEvent>&	events,
+		const double				theta,
+		const int					wind,
+		const double				numStd,
+		const int					numt,
+		const int					numx,
+		const int					numRan,		//	rannacher steps
+		const double				conc,
+		double&						res0,
+		string&						error);
+};
@@ -5,12 +5,87 @@
 //	includes
 #include "kVector.h"
 #include "kMatrix.h"
+#include "kInlines.h"
+#include <type_traits>
+#include <algorithm>
+
+//	grid tags
+struct kGridGeneral {};		//	any grid: stencils per node
+struct kGridUniform {};		//	uniform grid: stencils of the first, interior and last node only
+
+//	n x 3 stencil storage, compact on uniform grids where all interior rows coincide
+template <class V, class G = kGridGeneral>
+class kStencil
+{
+public:
+
+	static constexpr bool uniform = std::is_same_v<G, kGridUniform>;
+
+	//	dims
+	int		rows()	const { return myN; }
+	int		cols()	const { return myS.cols(); }
+
+	//	storage row of node i
+	int		idx(int i) const
+	{
+		if constexpr(uniform)	return i==0 ? 0 : (i<myN-1 ? 1 : myS.rows()-1);
+		else					return i;
+	}
+
+	//	element access
+	const V&	operator()(int i, int j) const	{ return myS(idx(i),j); }
+	V&			operator()(int i, int j)		{ return myS(idx(i),j); }
+
+	//	stored rows: n x 3, or first, interior and last row on uniform grids
+	const kMatrix<V>&	data()	const { return myS; }
+	kMatrix<V>&			data()	{ return myS; }
+
+	//	nodes spanned by the stored rows
+	const kVector<V>&	nodes(const kVector<V>& x)
+	{
+		myN = x.size();
+		if constexpr(!uniform) return x;
+
+		//	first 3 nodes of the uniform grid through x(0) and x(n-1)
+		int m = min(myN, 3);
+		V	h = myN>1 ? (x(myN-1) - x(0)) / (myN - 1) : V(0.0);
+		myX.resize(m);
+		for(int i=0;i<m;++i) myX(i) = x(0) + i*h;
+		return myX;
+	}
+
+private:
+	kMatrix<V>	myS;
+	kVector<V>	myX;
+	int			myN{0};
+};
 
 //	class declaration
 class kFiniteDifference
 {
 public:
 
+	//	1st order diff operator into stencil storage
+	template <class V, class G>
+	static void	dx(
+		int					wind,
+		const kVector<V>&	x,
+		kStencil<V,G>&		out)
+	{
+		const kVector<V>& xs = out.nodes(x);
+		dx(wind, xs, out.data());
+	}
+
+	//	2nd order diff operator into stencil storage
+	template <class V, class G>
+	static void	dxx(
+		const kVector<V>&	x,
+		kStencil<V,G>&		out)
+	{
+		const kVector<V>& xs = out.nodes(x);
+		dxx(xs, out.data());
+	}
+
 	//	1st order diff operator
 	template <class V>
 	static void	dx(
@@ -210,4 +285,196 @@ public:
 		return res;
 	}
 
+	//	cubic lagrange interpolation of the columns of v (n x m) on grid x at x0
+	//	into out (m), through the 4 nodes around x0, exact on nodes, flat
+	//	beyond the ends
+	template <class V>
+	static void	interpolate(
+		const kVector<V>&	x,
+		const kMatrix<V>&	v,
+		const V&			x0,
+		kVector<V>&			out)
+	{
+		//	dims
+		int n = x.size();
+		int m = v.cols();
+		out.resize(m, V(0.0));
+		if(!n) return;
+
+		//	helps
+		int i, j, k, il, iu;
+
+		//	node at or left of x0
+		i = (int)(std::upper_bound(x.data().begin(), x.data().end(), x0) - x.data().begin()) - 1;
+		if(i<0 || x0==x(i) || i==n-1)
+		{
+			i = max(0, i);
+			for(k=0;k<m;++k) out(k) = v(i,k);
+			return;
+		}
+
+		//	stencil
+		il = max(0, min(i-1, n-4));
+		iu = min(n-1, il+3);
+		for(k=0;k<m;++k) out(k) = 0.0;
+		for(j=il;j<=iu;++j)
+		{
+			V w = 1.0;
+			for(int l=il;l<=iu;++l)
+			{
+				if(l!=j) w *= (x0 - x(l)) / (x(j) - x(l));
+			}
+			for(k=0;k<m;++k) out(k) += w * v(j,k);
+		}
+
+		//	done
+		return;
+	}
+
+	//	monotone cubic interpolation (fritsch-butland slopes) of v on grid x at
+	//	the ascending points xq into out, flat beyond the ends. one pass over
+	//	the grid for all points, the slopes in workspace d
+	template <class V>
+	static void	monotoneInterpolate(
+		const kVector<V>&	x,
+		const kVector<V>&	v,
+		const kVector<V>&	xq,
+		kVector<V>&			out,
+		kVector<V>&			d)
+	{
+		//	dims
+		int n = x.size();
+		int m = xq.size();
+		out.resize(m);
+		d.resize(n);
+		if(!n) return;
+
+		//	helps
+		int i, k;
+		V h0, h1, d0, d1;
+
+		//	slopes at the nodes: one sided at the ends, harmonic means inside, 0 at extrema
+		d(0) = d(n-1) = V(0.0);
+		if(n>1)
+		{
+			d(0)   = (v(1) - v(0)) / (x(1) - x(0));
+			d(n-1) = (v(n-1) - v(n-2)) / (x(n-1) - x(n-2));
+		}
+		for(i=1;i<n-1;++i)
+		{
+			h0 = x(i) - x(i-1);
+			h1 = x(i+1) - x(i);
+			d0 = (v(i) - v(i-1)) / h0;
+			d1 = (v(i+1) - v(i)) / h1;
+			d(i) = d0*d1>0.0 ? 3.0*(h0 + h1) / ((2.0*h1 + h0)/d0 + (h1 + 2.0*h0)/d1) : V(0.0);
+		}
+
+		//	hermite cubics, the interval advances with the points
+		i = 0;
+		for(k=0;k<m;++k)
+		{
+			if(xq(k)<=x(0))		{ out(k) = v(0); continue; }
+			if(xq(k)>=x(n-1))	{ out(k) = v(n-1); continue; }
+			while(xq(k)>x(i+1)) ++i;
+			V h = x(i+1) - x(i);
+			V t = (xq(k) - x(i)) / h;
+			V t2 = t*t, t3 = t2*t;
+			out(k) = (2.0*t3 - 3.0*t2 + 1.0)*v(i) + (t3 - 2.0*t2 + t)*h*d(i)
+				   + (-2.0*t3 + 3.0*t2)*v(i+1) + (t3 - t2)*h*d(i+1);
+		}
+
+		//	done
+		return;
+	}
+
+	//	linear interpolation of v on grid x at the ascending points xq into out,
+	//	flat beyond the ends. the intervals and weights are found in one pass over
+	//	the grid into il and w, then the values in a branch free loop over the points
+	template <class V>
+	static void	linearInterpolate(
+		const kVector<V>&	x,
+		const kVector<V>&	v,
+		const kVector<V>&	xq,
+		kVector<V>&			out,
+		kVector<int>&		il,
+		kVector<V>&			w)
+	{
+		//	dims
+		int n = x.size();
+		int m = xq.size();
+		out.resize(m);
+		il.resize(m);
+		w.resize(m);
+		if(!n) return;
+		if(n==1)
+		{
+			for(int k=0;k<m;++k) out(k) = v(0);
+			return;
+		}
+
+		//	intervals and weights of the upper nodes, clamped to the ends
+		int i = 0;
+		for(int k=0;k<m;++k)
+		{
+			while(i<n-2 && xq(k)>x(i+1)) ++i;
+			V t = (xq(k) - x(i)) / (x(i+1) - x(i));
+			il(k) = i;
+			w(k)  = t<0.0 ? V(0.0) : t>1.0 ? V(1.0) : t;
+		}
+
+		//	values
+		const V* pv = v.data().data();
+		for(int k=0;k<m;++k)
+		{
+			V vl = pv[il(k)];
+			out(k) = vl + w(k) * (pv[il(k)+1] - vl);
+		}
+
+		//	done
+		return;
+	}
+
+	//	vanilla payoff on grid s: call/put (pc = 1/-1), digital or not, optionally smoothed over the cells
+	template <class V>
+	static void	vanillaPayoff(
+		const kVector<V>&	s,
+		const V&			strike,
+		const bool			dig,
+		const int			pc,
+		const int			smooth,
+		kVector<V>&			res)
+	{
+		//	dims
+		int nums = s.size();
+		res.resize(nums);
+
+		//	helps
+		V sl, su;
+
+		for(int i=0;i<nums;++i)
+		{
+			if(smooth==0 || i==0 || i==nums-1)
+			{
+				if(dig) res(i) = 0.5*(kInlines::sign(s(i)-strike)+1.0);
+				else    res(i) = max(V(0.0), s(i) - strike);
+			}
+			else
+			{
+				sl = 0.5 * (s(i - 1) + s(i));
+				su = 0.5 * (s(i) + s(i + 1));
+				if(dig) res(i) = smoothDigital(sl, su, strike);
+				else	res(i) = smoothCall(sl, su, strike);
+			}
+
+			if(pc<0)
+			{
+				if(dig) res(i) =  1.0 - res(i);
+				else    res(i) -= (s(i) - strike);
+			}
+		}
+
+		//	done
+		return;
+	}
+
 };
@@ -0,0 +1,102 @@
+#include "kHeston.h"
+#include "kBlack.h"
+#include "kFd2d.h"
+#include "kFdGrid.h"
+
+//	fd runner
+bool
+kHeston::fdRunner(
+	const double		s0,
+	const double		v0,
+	const double		r,
+	const double		mu,
+	const double		kappa,
+	const double		vbar,
+	const double		eta,
+	const double		rho,
+	const double		expiry,
+	const double		strike,
+	const bool			dig,
+	const int			pc,
+	const int			smooth,
+	const double		theta,
+	const int			wind,
+	const double		numStd,
+	const int			numT,
+	const int			numS,
+	const int			numV,
+	const int			scheme,
+	double&				res0,
+	string&				error,
+	const bool			parallel,
+	kThreadPool*		pool)
+{
+	//	helps
+	int h, i, j;
+
+	//	check
+	if(s0<=0.0 || v0<0.0 || vbar<0.0 || eta<0.0 || kappa<0.0 || rho<-1.0 || rho>1.0 || numV<4 || scheme<0 || scheme>3)
+	{
+		error = "kHeston::fdRunner: need s0 > 0, v0, vbar, eta, kappa >= 0, |rho| <= 1, numV >= 4 and scheme 0..3";
+		return false;
+	}
+
+	//	s axis
+	double t  = max(0.0, expiry);
+	double vm = max(v0, vbar);
+	kVector<double> s;
+	kBlack::fdGrid(s0, sqrt(max(vm, 1.0e-8)), t, numStd, numS, s);
+	int nums = s.size();
+	kVector<double> x(nums);
+	for(i=0;i<nums;++i) x(i) = log(s(i));
+
+	//	v axis
+	double vmax = vm + numStd * eta * sqrt(vm * max(t, 1.0e-8));
+	kVector<double> v, points(2);
+	points(0) = v0;
+	points(1) = 0.0;
+	kVector<int> snaps(2);
+	snaps(0) = kFdGrid::node;
+	snaps(1) = kFdGrid::none;
+	if(!kFdGrid::concentrated(0.0, vmax, numV, points, snaps, 0.1*vmax, v, error)) return false;
+	int numv = v.size();
+
+	//	fd
+	kFd2d<double> fd;
+	fd.init(x, v);
+	fd.setParallel(parallel, pool);
+	for(i=0;i<nums;++i)
+	{
+		for(j=0;j<numv;++j)
+		{
+			fd.r()(i,j)	   = r;
+			fd.mux()(i,j)  = mu - 0.5*v(j);
+			fd.varx()(i,j) = v(j);
+			fd.muy()(i,j)  = kappa * (vbar - v(j));
+			fd.vary()(i,j) = eta * eta * v(j);
+			fd.cov()(i,j)  = rho * eta * v(j);
+		}
+	}
+
+	//	terminal result
+	kVector<double> payoff;
+	kFiniteDifference::vanillaPayoff(s, strike, dig, pc, smooth, payoff);
+	for(i=0;i<nums;++i)
+	{
+		for(j=0;j<numv;++j) fd.res()(i,j) = payoff(i);
+	}
+
+	//	roll
+	int    numt = max(0, numT);
+	double dt	= t / max(1, numt);
+	for(h=numt-1;h>=0;--h)
+	{
+		fd.rollBwd(dt, false, theta, wind, (kFd2d<double>::Scheme)scheme);
+	}
+
+	//	result at s0, v0
+	res0 = fd.res()(nums/2, kFdGrid::index(v, v0));
+
+	//	done
+	return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+//	desc:	heston model by 2d adi finite differences
+//
+//		ds = mu s dt + sqrt(v) s dW1
+//		dv = kappa (vbar - v) dt + eta sqrt(v) dW2,		dW1 dW2 = rho dt
+//
+//	solved with kFd2d in x = log(s) on the log equidistant grid of kBlack with
+//	vol sqrt(max(v0, vbar)), and in v on [0, vmax] concentrated around 0 and
+//	v0, v0 on a node. vmax is max(v0, vbar) plus numStd standard deviations of
+//	the stationary variance scaled by the expiry
+
+//	includes
+#include "kVector.h"
+#include <string>
+
+using std::string;
+
+//	forward declaration
+class kThreadPool;
+
+class kHeston
+{
+public:
+
+	//	fd runner, scheme: douglas (0), craig-sneyd (1), modified craig-sneyd (2),
+	//	hundsdorfer-verwer (3), parallel sweeps on pool (null for the shared one)
+	static bool	fdRunner(
+		const double		s0,
+		const double		v0,
+		const double		r,
+		const double		mu,
+		const double		kappa,
+		const double		vbar,
+		const double		eta,
+		const double		rho,
+		const double		expiry,
+		const double		strike,
+		const bool			dig,
+		const int			pc,			//	put (-1) call (1)
+		const int			smooth,		//	smoothing
+		const double		theta,
+		const int			wind,
+		const double		numStd,
+		const int			numT,
+		const int			numS,
+		const int			numV,
+		const int			scheme,
+		double&				res0,
+		string&				error,
+		const bool			parallel = false,
+		kThreadPool*		pool = nullptr);
+};
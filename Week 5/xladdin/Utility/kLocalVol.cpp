@@ -0,0 +1,380 @@
+#include "kLocalVol.h"
+#include "kFdChain.h"
+#include "kBlack.h"
+#include "kFd1d.h"
+#include "kMatrixAlgebra.h"
+
+//	slice of the calibration: grid, knots, weights and quotes of one expiry
+struct kLocalVolSlice
+{
+	//	steps, the leading numRan as two implicit half steps each
+	double			dt;
+	int				numSteps;
+	int				numRan;
+
+	//	node i interpolates knots jl(i) and jl(i)+1 with weights a(i) and 1 - a(i)
+	kVector<int>	jl;
+	kVector<double>	a;
+
+	//	payoffs n x numK, target prices and vegas
+	kMatrix<double>	payoff;
+	kVector<double>	target;
+	kVector<double>	vega;
+};
+
+//	local vols at the knots onto var at the nodes
+static void
+setVar(
+	const kVector<double>&	s,
+	const kLocalVolSlice&	sl,
+	const kVector<double>&	sig,
+	kVector<double>&		var)
+{
+	int numK = sig.size();
+	for(int i=0;i<s.size();++i)
+	{
+		int j = sl.jl(i);
+		double v = sl.a(i)*sig(j) + (1.0-sl.a(i))*sig(min(j+1, numK-1));
+		var(i) = kInlines::sqr(v * s(i));
+	}
+}
+
+//	curvature penalty rows of the residuals and the jacobian, after the numK price rows
+static void
+setReg(
+	const double			reg,
+	const kVector<double>&	sig,
+	kVector<double>&		res,
+	kMatrix<double>*		jac)
+{
+	int numK = sig.size();
+	double w = sqrt(max(0.0, reg));
+	for(int j=1;j<numK-1;++j)
+	{
+		res(numK+j-1) = w * (sig(j-1) - 2.0*sig(j) + sig(j+1));
+		if(jac)
+		{
+			(*jac)(numK+j-1,j-1) = w;
+			(*jac)(numK+j-1,j)	 = -2.0*w;
+			(*jac)(numK+j-1,j+1) = w;
+		}
+	}
+}
+
+//	fwd roll of res over the first numSteps steps of the slice
+static void
+rollFwd(
+	kFd1d<double>&			fd,
+	const kLocalVolSlice&	sl,
+	const double			theta,
+	const int				wind,
+	const int				numSteps,
+	kSlotMatrix<double>&	res)
+{
+	double dtc = -1.0, thetac = -1.0;
+	for(int h=0;h<numSteps;++h)
+	{
+		bool half = h<sl.numRan;
+		double dth = half ? 0.5*sl.dt : sl.dt;
+		double th  = half ? 1.0 : theta;
+		for(int k=0;k<(half ? 2 : 1);++k)
+		{
+			fd.rollFwd(dth, dth!=dtc || th!=thetac, th, wind, res);
+			dtc	   = dth;
+			thetac = th;
+		}
+	}
+}
+
+//	residuals by a fwd roll of q over the slice, the weights at its end into qOut if given
+static void
+residuals(
+	kFd1d<double>&			fd,
+	const kLocalVolSlice&	sl,
+	const kVector<double>&	q,
+	const double			theta,
+	const int				wind,
+	const double			reg,
+	const kVector<double>&	sig,
+	kVector<double>&		res,
+	kVector<double>*		qOut = nullptr)
+{
+	//	dims
+	int n	 = q.size();
+	int numK = sig.size();
+
+	//	roll
+	setVar(fd.x(), sl, sig, fd.var());
+	fd.res().setSlot(0, q);
+	rollFwd(fd, sl, theta, wind, sl.numSteps, fd.res());
+
+	//	prices
+	res.assign(numK + max(0, numK-2), 0.0);
+	for(int k=0;k<numK;++k)
+	{
+		double p = 0.0;
+		for(int i=0;i<n;++i) p += fd.res()(0,i) * sl.payoff(i,k);
+		res(k) = (p - sl.target(k)) / sl.vega(k);
+	}
+	setReg(reg, sig, res, nullptr);
+	if(qOut) fd.res().getSlot(0, *qOut);
+}
+
+//	residuals and jacobian by a bwd adjoint roll per strike, split into the
+//	full steps and the leading half steps: the adjoint weights at the end of
+//	the half steps are q rolled fwd over them, the transpose of their bwd roll
+static void
+jacobian(
+	kFd1d<double>&			fd,
+	const kLocalVolSlice&	sl,
+	const kVector<double>&	q,
+	const double			theta,
+	const int				wind,
+	const double			reg,
+	const kVector<double>&	sig,
+	kVector<double>&		res,
+	kMatrix<double>&		jac)
+{
+	//	helps
+	int i, k;
+
+	//	dims
+	const kVector<double>& s = fd.x();
+	int n	 = q.size();
+	int numK = sig.size();
+
+	//	workspace
+	kSlotMatrix<double> v(1, n), w(1, n), wf(1, n), dres;
+	kVector<double> dr, dmu, dvar, dvarh;
+	w.setSlot(0, q);
+
+	//	weights after the half steps
+	setVar(s, sl, sig, fd.var());
+	int numFull = sl.numSteps - sl.numRan;
+	wf.setSlot(0, q);
+	rollFwd(fd, sl, theta, wind, sl.numRan, wf);
+
+	//	rows
+	res.assign(numK + max(0, numK-2), 0.0);
+	jac.resize(res.size(), numK);
+	jac = 0.0;
+	for(k=0;k<numK;++k)
+	{
+		for(i=0;i<n;++i) v(0,i) = sl.payoff(i,k);
+		if(numFull>0)	fd.rollBwdAdjoint(sl.dt, numFull, theta, wind, v, wf, dr, dmu, dvar, dres);
+		else			dvar.assign(n, 0.0);
+		if(sl.numRan>0)
+		{
+			fd.rollBwdAdjoint(0.5*sl.dt, 2*sl.numRan, 1.0, wind, v, w, dr, dmu, dvarh, dres);
+			for(i=0;i<n;++i) dvar(i) += dvarh(i);
+		}
+
+		//	price q v, d var(i) / d sig = 2 sigma(s_i) s_i^2 per knot weight
+		double p = 0.0;
+		for(i=0;i<n;++i)
+		{
+			p += q(i) * v(0,i);
+			int j = sl.jl(i);
+			double d = 2.0 * sqrt(fd.var()(i)) * s(i) * dvar(i) / sl.vega(k);
+			jac(k,j) += sl.a(i) * d;
+			if(sl.a(i)<1.0) jac(k,j+1) += (1.0-sl.a(i)) * d;
+		}
+		res(k) = (p - sl.target(k)) / sl.vega(k);
+	}
+	setReg(reg, sig, res, &jac);
+}
+
+//	calibrate
+bool
+kLocalVol::calibrate(
+	const double			s0,
+	const double			r,
+	const double			mu,
+	const kVector<double>&	expiries,
+	const kMatrix<double>&	strikes,
+	const kMatrix<double>&	vols,
+	const double			theta,
+	const int				wind,
+	const double			numStd,
+	const int				numt,
+	const int				numx,
+	const int				numRan,
+	const double			reg,
+	const int				maxIter,
+	kMatrix<double>&		localVols,
+	kMatrix<double>&		fit,
+	string&					error)
+{
+	//	helps
+	int e, i, j, k, it;
+
+	//	dims
+	int numE = expiries.size();
+	int numK = strikes.cols();
+	if(strikes.rows()!=numE || vols.rows()!=numE || vols.cols()!=numK || numK<1)
+	{
+		error = "kLocalVol::calibrate(): need numE x numK strikes and vols";
+		return false;
+	}
+	for(e=0;e<numE;++e)
+	{
+		if(expiries(e)<=(e ? expiries(e-1) : 0.0))
+		{
+			error = "kLocalVol::calibrate(): expiries must be positive and ascending";
+			return false;
+		}
+		for(k=1;k<numK;++k)
+		{
+			if(strikes(e,k)<=strikes(e,k-1))
+			{
+				error = "kLocalVol::calibrate(): strikes must be ascending";
+				return false;
+			}
+		}
+	}
+	localVols.resize(numE, numK);
+	fit.resize(numE, numK);
+	if(!numE) return true;
+
+	//	grid over the last expiry at the largest quote, s0 on the middle node
+	double sigMax = 0.0;
+	for(i=0;i<vols.size();++i) sigMax = max(sigMax, vols[i]);
+	kVector<double> s;
+	kBlack::fdGrid(s0, sigMax, expiries(numE-1), numStd, numx, s);
+	int n = s.size();
+	if(n<3)
+	{
+		error = "kLocalVol::calibrate(): grid too small";
+		return false;
+	}
+
+	//	fd
+	kFd1d<double> fd;
+	fd.init(1, s, false);
+	for(i=0;i<n;++i)
+	{
+		fd.r()(i)  = r;
+		fd.mu()(i) = mu * s(i);
+	}
+
+	//	steps per slice
+	kVector<int> numSteps;
+	kFdChain::steps(expiries, numt, numSteps);
+
+	//	the first numRan steps implicit, over as many slices as they take
+	int ran = max(0, numRan);
+
+	//	weights of node n/2
+	kVector<double> q(n, 0.0), qn;
+	q(n/2) = 1.0;
+
+	//	workspace
+	kLocalVolSlice sl;
+	kVector<double> sig(numK), trial(numK), res, resT, g(numK), step(numK), f;
+	kMatrix<double> jac, A(numK, numK);
+	kVector<double> knots(numK);
+
+	//	bootstrap
+	for(e=0;e<numE;++e)
+	{
+		double t  = expiries(e);
+		double df = exp(-r * t);
+		double fw = s0 * exp(mu * t);
+
+		//	steps
+		sl.numSteps = numSteps(e);
+		sl.dt		= (t - (e ? expiries(e-1) : 0.0)) / sl.numSteps;
+		sl.numRan	= min(ran, sl.numSteps);
+		ran		   -= sl.numRan;
+
+		//	knot weights
+		for(k=0;k<numK;++k) knots(k) = strikes(e,k);
+		sl.jl.resize(n);
+		sl.a.resize(n);
+		for(i=0;i<n;++i)
+		{
+			j = (int)(std::upper_bound(knots.data().begin(), knots.data().end(), s(i)) - knots.data().begin()) - 1;
+			if(j<0)					{ sl.jl(i) = 0; sl.a(i) = 1.0; }
+			else if(j>=numK-1)		{ sl.jl(i) = numK-1; sl.a(i) = 1.0; }
+			else
+			{
+				sl.jl(i) = j;
+				sl.a(i)	 = (knots(j+1) - s(i)) / (knots(j+1) - knots(j));
+			}
+		}
+
+		//	payoffs and quotes, vegas floored at a hundredth of atm
+		sl.payoff.resize(n, numK);
+		sl.target.resize(numK);
+		sl.vega.resize(numK);
+		double vegaMin = 0.01 * df * kBlack::vega(t, fw, fw, sigMax);
+		for(k=0;k<numK;++k)
+		{
+			kFiniteDifference::vanillaPayoff(s, knots(k), false, 1, 1, f);
+			for(i=0;i<n;++i) sl.payoff(i,k) = f(i);
+			sl.target(k) = df * kBlack::call(t, knots(k), fw, vols(e,k));
+			sl.vega(k)	 = max(vegaMin, df * kBlack::vega(t, knots(k), fw, vols(e,k)));
+			sig(k)		 = vols(e,k);
+		}
+
+		//	levenberg-marquardt from the implied vols
+		double lambda = 1.0e-3;
+		jacobian(fd, sl, q, theta, wind, reg, sig, res, jac);
+		double cost = 0.0;
+		for(i=0;i<res.size();++i) cost += res(i)*res(i);
+		for(it=0;it<maxIter;++it)
+		{
+			//	normal equations
+			for(j=0;j<numK;++j)
+			{
+				g(j) = 0.0;
+				for(i=0;i<res.size();++i) g(j) -= jac(i,j) * res(i);
+				for(k=0;k<=j;++k)
+				{
+					double d = 0.0;
+					for(i=0;i<res.size();++i) d += jac(i,j) * jac(i,k);
+					A(j,k) = A(k,j) = d;
+				}
+			}
+
+			//	damped steps until the cost decreases
+			bool accepted = false;
+			double costT = cost;
+			while(!accepted && lambda<1.0e10)
+			{
+				kMatrix<double> B = A;
+				for(j=0;j<numK;++j) B(j,j) += lambda * (A(j,j) + 1.0e-12);
+				if(kMatrixAlgebra::cholesky(B, g, step))
+				{
+					for(j=0;j<numK;++j) trial(j) = max(1.0e-4, sig(j) + step(j));
+					residuals(fd, sl, q, theta, wind, reg, trial, resT);
+					costT = 0.0;
+					for(i=0;i<resT.size();++i) costT += resT(i)*resT(i);
+					accepted = costT<cost;
+				}
+				lambda = accepted ? max(1.0e-9, lambda/3.0) : 4.0*lambda;
+			}
+			if(!accepted) break;
+
+			//	converged once the cost stalls
+			bool done = cost - costT <= 1.0e-10 * cost;
+			sig	 = trial;
+			cost = costT;
+			if(done) break;
+			jacobian(fd, sl, q, theta, wind, reg, sig, res, jac);
+		}
+
+		//	roll the weights over the slice, model implied vols
+		residuals(fd, sl, q, theta, wind, reg, sig, res, &qn);
+		q = qn;
+		for(k=0;k<numK;++k)
+		{
+			double p = res(k) * sl.vega(k) + sl.target(k);
+			localVols(e,k) = sig(k);
+			fit(e,k)	   = kBlack::implied(t, knots(k), p / df, fw);
+		}
+	}
+
+	//	done
+	return true;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+//	desc:	local volatility calibration on the forward fd solve
+//
+//		ds = mu s dt + sigma(s, t) s dW
+//
+//	sigma is piecewise linear in s through the strikes of every expiry, flat
+//	beyond them, and constant in t between two expiries. the slices are
+//	bootstrapped expiry by expiry: the arrow-debreu weights q at the last
+//	expiry are rolled fwd over the next slice (kFdChain) and the slice vols
+//	fitted by levenberg-marquardt to the black implied vol quotes, residuals
+//	are price errors over black vega, plus reg times the second differences
+//	of the vols over the knots
+//
+//	the jacobian is analytic: a slice price is q f for the bwd roll f of the
+//	payoff over the slice, the adjoint of the fwd roll, and
+//	kFd1d::rollBwdAdjoint differentiates it to var at every node, one run per
+//	strike. model vols are implied by kBlack::implied
+//
+//	as in kFdChain the first numRan steps are replaced by two implicit half
+//	steps each against the oscillations of the point mass start, in the
+//	residuals and in the jacobian alike
+
+//	includes
+#include "kVector.h"
+#include "kMatrix.h"
+#include <string>
+
+using std::string;
+
+class kLocalVol
+{
+public:
+
+	//	calibrate numE x numK local vols at the strikes, strikes ascending per
+	//	expiry, expiries ascending. fit holds the implied vols of the model
+	static bool	calibrate(
+		const double			s0,
+		const double			r,
+		const double			mu,
+		const kVector<double>&	expiries,
+		const kMatrix<double>&	strikes,
+		const kMatrix<double>&	vols,		//	black implied vol quotes
+		const double			theta,
+		const int				wind,
+		const double			numStd,
+		const int				numt,
+		const int				numx,
+		const int				numRan,		//	rannacher steps
+		const double			reg,		//	weight of the second differences
+		const int				maxIter,	//	levenberg-marquardt iterations per expiry
+		kMatrix<double>&		localVols,
+		kMatrix<double>&		fit,
+		string&					error);
+};
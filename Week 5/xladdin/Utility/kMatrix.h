@@ -9,14 +9,14 @@ class kMatrix
 {
 public:
 	//	declarations
-	using Container=vector<T>;
+	using Container=std::pmr::vector<T>;
 	using value_type = T;
 
-	//	trivi c'tors
-	kMatrix()=default;
-	kMatrix(size_t rows, size_t cols) : myData(rows*cols),myRows((int)rows),myCols((int)cols){}
-	kMatrix(size_t rows, size_t cols, T t0) : myData(rows*cols,t0),myRows((int)rows),myCols((int)cols){}
-	kMatrix(const kMatrix& rhs)=default;
+	//	trivi c'tors, storage comes from the current kMemory resource
+	kMatrix() : myData(kMemory::current()){}
+	kMatrix(size_t rows, size_t cols) : myData(rows*cols,kMemory::current()),myRows((int)rows),myCols((int)cols){}
+	kMatrix(size_t rows, size_t cols, T t0) : myData(rows*cols,t0,kMemory::current()),myRows((int)rows),myCols((int)cols){}
+	kMatrix(const kMatrix& rhs) : myData(rhs.myData,kMemory::current()),myRows(rhs.myRows),myCols(rhs.myCols){}
 	kMatrix(kMatrix&& rhs)noexcept=default;
 	~kMatrix()noexcept=default;
 
@@ -90,7 +90,7 @@ public:
 			return;
 		}
 
-		Container tmp;
+		Container tmp(myData.get_allocator());
 		swap(tmp,myData);
 		myData.resize(rows*cols,t0);
 
@@ -160,14 +160,14 @@ public:
 	kMatrixView(T& rhs) : myView(&rhs,1),myRows(1),myCols(1){}
 	kMatrixView(const T& rhs) : myView(&const_cast<T&>(rhs),1),myRows(1),myCols(1){}
 
-	kMatrixView(vector<T>& rhs, size_t rows, size_t cols) : myView(rhs),myRows((int)rows),myCols((int)cols)
+	template<class A> kMatrixView(vector<T,A>& rhs, size_t rows, size_t cols) : myView(rhs),myRows((int)rows),myCols((int)cols)
 	{
 #ifdef _DEBUG
 		if(myRows*myCols!=myView.size()) throw std::runtime_error("kMatrixView::kMatrixView(vector): Row/col vs view size mismatch");
 #endif
 	}
 
-	kMatrixView(const vector<T>& rhs, size_t rows, size_t cols) : myView(const_cast<vector<T>&>(rhs)),myRows((int)rows),myCols((int)cols)
+	template<class A> kMatrixView(const vector<T,A>& rhs, size_t rows, size_t cols) : myView(const_cast<vector<T,A>&>(rhs)),myRows((int)rows),myCols((int)cols)
 	{
 #ifdef _DEBUG
 		if(myRows*myCols!=myView.size()) throw std::runtime_error("kMatrixView::kMatrixView(const vector): Row/col vs view size mismatch");
@@ -3,6 +3,7 @@
 //	includes
 #include "kMatrix.h"
 #include "kInlines.h"
+#include <cmath>
 
 //	class
 namespace kMatrixAlgebra
@@ -35,6 +36,55 @@ namespace kMatrixAlgebra
 		return;
 	}
 
+	//	cholesky: solves A u = r for symmetric positive definite A, A is
+	//	overwritten by its lower factor, false if A is not positive definite
+	template <class V>
+	bool	cholesky(
+		kMatrix<V>&			A,
+		const kVector<V>&	r,
+		kVector<V>&			u)
+	{
+		//	dims
+		int n = A.rows();
+		u.resize(n);
+
+		//	helps
+		int i, j, k;
+		V s;
+
+		//	factor A = L L^T
+		for(j=0;j<n;++j)
+		{
+			s = A(j,j);
+			for(k=0;k<j;++k) s -= A(j,k)*A(j,k);
+			if(!(s>0.0)) return false;
+			A(j,j) = sqrt(s);
+			for(i=j+1;i<n;++i)
+			{
+				s = A(i,j);
+				for(k=0;k<j;++k) s -= A(i,k)*A(j,k);
+				A(i,j) = s/A(j,j);
+			}
+		}
+
+		//	L y = r, L^T u = y
+		for(i=0;i<n;++i)
+		{
+			s = r(i);
+			for(k=0;k<i;++k) s -= A(i,k)*u(k);
+			u(i) = s/A(i,i);
+		}
+		for(i=n-1;i>=0;--i)
+		{
+			s = u(i);
+			for(k=i+1;k<n;++k) s -= A(k,i)*u(k);
+			u(i) = s/A(i,i);
+		}
+
+		//	done
+		return true;
+	}
+
 	//	tridag: solves A u = r when A is tridag
 	template <class V>
 	void	tridag(
@@ -87,6 +137,283 @@ namespace kMatrixAlgebra
 		return;
 	}
 
+	//	tridag factor: forward elimination of tridag A, stores 1/bet and gam for repeated solves
+	template <class V>
+	void	tridagFactor(
+		const kMatrixView<V>	A,		//	n x 3
+		kVectorView<V>			beti,
+		kVectorView<V>			gam)
+	{
+		//	helps
+		V bet;
+		int j;
+
+		//	dim
+		int n = A.rows();
+		if(!n) return;
+
+		//	go
+		bet     = A(0,1);
+		beti(0) = 1.0/bet;
+		for(j=1;j<n;++j)
+		{
+			gam(j)  = A(j-1,2)*beti(j-1);
+			bet     = A(j,1)-A(j,0)*gam(j);
+			beti(j) = 1.0/bet;
+		}
+
+		//	done
+		return;
+	}
+
+	//	tridag factor: forward elimination of tridag A, stores 1/bet and gam for repeated solves
+	template <class V>
+	void	tridagFactor(
+		const kMatrix<V>&		A,		//	n x 3
+		kVector<V>&				beti,
+		kVector<V>&				gam)
+	{
+		//	dim
+		int n = A.rows();
+
+		//	check dim
+		if(beti.size()<n) beti.resize(n);
+		if(gam.size()<n) gam.resize(n);
+
+		tridagFactor(A(), beti(), gam());
+
+		//	done
+		return;
+	}
+
+	//	tridag solve: solves A u = r using the factorization from tridagFactor, u and r may be the same
+	template <class V>
+	void	tridagSolve(
+		const kMatrixView<V>	A,		//	n x 3
+		const kVectorView<V>	beti,
+		const kVectorView<V>	gam,
+		const kVectorView<V>	r,
+		kVectorView<V>			u)
+	{
+		//	helps
+		int j;
+
+		//	dim
+		int n = A.rows();
+		if(!n) return;
+
+		//	go
+		u(0) = r(0)*beti(0);
+		for(j=1;j<n;++j)
+		{
+			u(j) = (r(j)-A(j,0)*u(j-1))*beti(j);
+		}
+		for(j=n-2;j>=0;--j)
+		{
+			u(j) -= gam(j+1)*u(j+1);
+		}
+
+		//	done
+		return;
+	}
+
+	//	tridag solve: solves A u = r using the factorization from tridagFactor, u and r may be the same
+	template <class V>
+	void	tridagSolve(
+		const kMatrix<V>&		A,		//	n x 3
+		const kVector<V>&		beti,
+		const kVector<V>&		gam,
+		const kVector<V>&		r,
+		kVector<V>&				u)
+	{
+		//	dim
+		int n = A.rows();
+
+		//	check dim
+		if(u.size()<n) u.resize(n);
+
+		tridagSolve(A(), beti(), gam(), r(), u());
+
+		//	done
+		return;
+	}
+
+	//	linear complementarity problems min(A u - r, u - g) = 0 for american
+	//	exercise, A an m matrix (fd implicit operators on stable grids). the
+	//	brennan-schwartz solver is exact if the exercise region u = g is one
+	//	interval at an end of the grid: elimination runs towards that end, the
+	//	projection max(u, g) rides along the substitution away from it. with
+	//	the exercise region at the high end the factorization is tridagFactor,
+	//	at the low end tridagFactorUL. the penalty iteration makes no such
+	//	assumption and costs a full solve per iteration
+
+	//	tridag factor: backward elimination of tridag A, stores 1/bet and gam for repeated projected solves
+	template <class V>
+	void	tridagFactorUL(
+		const kMatrixView<V>	A,		//	n x 3
+		kVectorView<V>			beti,
+		kVectorView<V>			gam)
+	{
+		//	helps
+		int j;
+
+		//	dim
+		int n = A.rows();
+		if(!n) return;
+
+		//	go
+		beti(n-1) = 1.0/A(n-1,1);
+		gam(n-1)  = A(n-1,0)*beti(n-1);
+		for(j=n-2;j>=0;--j)
+		{
+			beti(j) = 1.0/(A(j,1)-A(j,2)*gam(j+1));
+			gam(j)  = A(j,0)*beti(j);
+		}
+
+		//	done
+		return;
+	}
+
+	//	tridag factor: backward elimination of tridag A, stores 1/bet and gam for repeated projected solves
+	template <class V>
+	void	tridagFactorUL(
+		const kMatrix<V>&		A,		//	n x 3
+		kVector<V>&				beti,
+		kVector<V>&				gam)
+	{
+		//	dim
+		int n = A.rows();
+
+		//	check dim
+		if(beti.size()<n) beti.resize(n);
+		if(gam.size()<n) gam.resize(n);
+
+		tridagFactorUL(A(), beti(), gam());
+
+		//	done
+		return;
+	}
+
+	//	brennan-schwartz: solves min(A u - r, u - g) = 0 with the factorization from
+	//	tridagFactorUL (low, exercise at the low end) or tridagFactor, u and r may be the same
+	template <class V>
+	void	tridagSolveProjected(
+		const kMatrixView<V>	A,		//	n x 3
+		const kVectorView<V>	beti,
+		const kVectorView<V>	gam,
+		bool					low,
+		const kVectorView<V>	r,
+		const kVectorView<V>	g,
+		kVectorView<V>			u)
+	{
+		//	helps
+		int j;
+
+		//	dim
+		int n = A.rows();
+		if(!n) return;
+
+		//	go
+		if(low)
+		{
+			u(n-1) = r(n-1)*beti(n-1);
+			for(j=n-2;j>=0;--j)
+			{
+				u(j) = (r(j)-A(j,2)*u(j+1))*beti(j);
+			}
+			u(0) = max(u(0), g(0));
+			for(j=1;j<n;++j)
+			{
+				u(j) = max(u(j)-gam(j)*u(j-1), g(j));
+			}
+		}
+		else
+		{
+			u(0) = r(0)*beti(0);
+			for(j=1;j<n;++j)
+			{
+				u(j) = (r(j)-A(j,0)*u(j-1))*beti(j);
+			}
+			u(n-1) = max(u(n-1), g(n-1));
+			for(j=n-2;j>=0;--j)
+			{
+				u(j) = max(u(j)-gam(j+1)*u(j+1), g(j));
+			}
+		}
+
+		//	done
+		return;
+	}
+
+	//	penalty iteration: solves [A + P] u = r + P g with P = penalty on the nodes
+	//	where the previous iterate is below g, until these nodes stay the same or
+	//	no node moves by more than max(1, |u|) / penalty (the active set can cycle
+	//	on nodes where u and g nearly touch). u holds the first guess on entry,
+	//	d, w and gam are workspaces of size n, returns the number of solves,
+	//	u and r may not be the same
+	template <class V>
+	int		tridagPenalty(
+		const kMatrixView<V>	A,		//	n x 3
+		const kVectorView<V>	r,
+		const kVectorView<V>	g,
+		kVectorView<V>			u,
+		kVectorView<V>			d,
+		kVectorView<V>			w,
+		kVectorView<V>			gam,
+		V						penalty	= 1.0e8,
+		int						maxIter	= 50)
+	{
+		//	helps
+		V bet, p, du;
+		int j, it;
+		bool changed;
+
+		//	dim
+		int n = A.rows();
+		if(!n) return 0;
+
+		//	go
+		for(it=0;it<maxIter;++it)
+		{
+			//	penalized nodes
+			changed = false;
+			for(j=0;j<n;++j)
+			{
+				p = u(j)<g(j) ? penalty : V(0.0);
+				changed = changed || p!=d(j) || it==0;
+				d(j) = p;
+				w(j) = u(j);
+			}
+			if(!changed) break;
+
+			//	solve
+			bet  = A(0,1)+d(0);
+			u(0) = (r(0)+d(0)*g(0))/bet;
+			for(j=1;j<n;++j)
+			{
+				gam(j) = A(j-1,2)/bet;
+				bet    = A(j,1)+d(j)-A(j,0)*gam(j);
+				u(j)   = (r(j)+d(j)*g(j)-A(j,0)*u(j-1))/bet;
+			}
+			du = 0.0;
+			for(j=n-1;j>=0;--j)
+			{
+				if(j<n-1) u(j) -= gam(j+1)*u(j+1);
+				du = max(du, V(fabs(u(j)-w(j))/max(V(1.0), V(fabs(u(j))))));
+			}
+
+			//	converged
+			if(it>0 && du*penalty<=1.0)
+			{
+				++it;
+				break;
+			}
+		}
+
+		//	done
+		return it;
+	}
+
 	//	band diagonal matrix vector multiplication
 	template <class V>
 	void banmul(
@@ -247,5 +574,571 @@ namespace kMatrixAlgebra
 		return;
 	}
 
+	//	multi slot kernels: right hand sides and results are n x numV matrices
+	//	with the slot index as the inner (contiguous) dimension, so one pass
+	//	over the operator serves all slots
+
+	//	band diagonal matrix multiplication X = A B
+	template <class V>
+	void banmulMulti(
+		const kMatrixView<V> A,		//	n x 3
+		int					 m1,
+		int					 m2,
+		const kMatrixView<V> B,		//	n x numV
+		kMatrixView<V>		 X)		//	n x numV
+	{
+		int n = A.rows()-1;
+		int numV = B.cols();
+		int h;
+		V a;
+
+		//	tridiagonal, one pass over the slots per row
+		if(m1==1 && m2==1 && n>=1)
+		{
+			V a0, a1, a2;
+			a1 = A(0,1);
+			a2 = A(0,2);
+			{
+				const V* bi = &B(0,0);
+				const V* bu = &B(1,0);
+				V* xi = &X(0,0);
+				for(h=0;h<numV;++h) xi[h] = a1*bi[h] + a2*bu[h];
+			}
+			for(int i = 1;i<n;++i)
+			{
+				a0 = A(i,0);
+				a1 = A(i,1);
+				a2 = A(i,2);
+				const V* bl = &B(i-1,0);
+				const V* bi = &B(i,0);
+				const V* bu = &B(i+1,0);
+				V* xi = &X(i,0);
+				for(h=0;h<numV;++h) xi[h] = a0*bl[h] + a1*bi[h] + a2*bu[h];
+			}
+			a0 = A(n,0);
+			a1 = A(n,1);
+			{
+				const V* bl = &B(n-1,0);
+				const V* bi = &B(n,0);
+				V* xi = &X(n,0);
+				for(h=0;h<numV;++h) xi[h] = a0*bl[h] + a1*bi[h];
+			}
+			return;
+		}
+
+		//	general band
+		for(int i = 0;i<=n;++i)
+		{
+			int jl = max<int>(0, i - m1);
+			int ju = min<int>(i + m2, n);
+			V* xi = &X(i,0);
+			for(h=0;h<numV;++h) xi[h] = 0.0;
+			for(int j = jl;j<=ju;++j)
+			{
+				a = A(i,j - i + m1);
+				const V* bj = &B(j,0);
+				for(h=0;h<numV;++h) xi[h] += a*bj[h];
+			}
+		}
+
+		//	done
+		return;
+	}
+
+	//	band diagonal matrix multiplication X = A B
+	template <class V>
+	void banmulMulti(
+		const kMatrix<V>&	A,		//	n x 3
+		int					m1,
+		int					m2,	 
+		const kMatrix<V>&	B,		//	n x numV
+		kMatrix<V>&			X)		//	n x numV
+	{
+		X.resize(B.rows(), B.cols());
+
+		banmulMulti(A(), m1, m2, B(), X());
+
+		//	done
+		return;
+	}
+
+	//	tridag solve: solves A U = R using the factorization from tridagFactor, U and R may be the same
+	template <class V>
+	void	tridagSolveMulti(
+		const kMatrixView<V>	A,		//	n x 3
+		const kVectorView<V>	beti,
+		const kVectorView<V>	gam,
+		const kMatrixView<V>	R,		//	n x numV
+		kMatrixView<V>			U)		//	n x numV
+	{
+		//	helps
+		int j, h;
+		V a, b;
+
+		//	dims
+		int n = A.rows();
+		int numV = R.cols();
+		if(!n) return;
+
+		//	single slot: contiguous columns, scalar kernel
+		if(numV==1)
+		{
+			tridagSolve(A, beti, gam, kVectorView<V>(&R(0,0), n), kVectorView<V>(&U(0,0), n));
+			return;
+		}
+
+		//	go
+		{
+			const V* r0 = &R(0,0);
+			V* u0 = &U(0,0);
+			b = beti(0);
+			for(h=0;h<numV;++h) u0[h] = r0[h]*b;
+		}
+		for(j=1;j<n;++j)
+		{
+			const V* rj = &R(j,0);
+			const V* ul = &U(j-1,0);
+			V* uj = &U(j,0);
+			a = A(j,0);
+			b = beti(j);
+			for(h=0;h<numV;++h) uj[h] = (rj[h]-a*ul[h])*b;
+		}
+		for(j=n-2;j>=0;--j)
+		{
+			const V* uu = &U(j+1,0);
+			V* uj = &U(j,0);
+			a = gam(j+1);
+			for(h=0;h<numV;++h) uj[h] -= a*uu[h];
+		}
+
+		//	done
+		return;
+	}
+
+	//	transposed tridag solve: solves A^T U = R using the factorization of A from
+	//	tridagFactor, A = L W with L lower (1/beti, A(j,0)) and W unit upper (gam),
+	//	so W^T is eliminated downwards and L^T upwards. U and R may be the same
+	template <class V>
+	void	tridagSolveTransposedMulti(
+		const kMatrixView<V>	A,		//	n x 3
+		const kVectorView<V>	beti,
+		const kVectorView<V>	gam,
+		const kMatrixView<V>	R,		//	n x numV
+		kMatrixView<V>			U)		//	n x numV
+	{
+		//	helps
+		int j, h;
+		V a, b;
+
+		//	dims
+		int n = A.rows();
+		int numV = R.cols();
+		if(!n) return;
+
+		//	go
+		{
+			const V* r0 = &R(0,0);
+			V* u0 = &U(0,0);
+			for(h=0;h<numV;++h) u0[h] = r0[h];
+		}
+		for(j=1;j<n;++j)
+		{
+			const V* rj = &R(j,0);
+			const V* ul = &U(j-1,0);
+			V* uj = &U(j,0);
+			a = gam(j);
+			for(h=0;h<numV;++h) uj[h] = rj[h]-a*ul[h];
+		}
+		{
+			V* un = &U(n-1,0);
+			b = beti(n-1);
+			for(h=0;h<numV;++h) un[h] *= b;
+		}
+		for(j=n-2;j>=0;--j)
+		{
+			const V* uu = &U(j+1,0);
+			V* uj = &U(j,0);
+			a = A(j+1,0);
+			b = beti(j);
+			for(h=0;h<numV;++h) uj[h] = (uj[h]-a*uu[h])*b;
+		}
+
+		//	done
+		return;
+	}
+
+	//	interleaved lines: m independent tridiagonal systems of n rows stored
+	//	n x m with the system index inner, the sub, main and super diagonals
+	//	in separate n x m matrices. the sweeps run down all systems at once,
+	//	so the inner loops are contiguous and free of recurrences. jl..ju-1
+	//	selects the systems, e.g. a block per thread
+
+	//	tridag factor of interleaved lines
+	template <class V>
+	void	tridagFactorLines(
+		const kMatrixView<V>	A0,		//	n x m
+		const kMatrixView<V>	A1,
+		const kMatrixView<V>	A2,
+		kMatrixView<V>			beti,
+		kMatrixView<V>			gam,
+		int						jl,
+		int						ju)
+	{
+		//	helps
+		int i, j;
+
+		//	dim
+		int n = A1.rows();
+		if(!n) return;
+
+		//	go
+		for(j=jl;j<ju;++j) beti(0,j) = 1.0/A1(0,j);
+		for(i=1;i<n;++i)
+		{
+			const V* a0 = &A0(i,0);
+			const V* a1 = &A1(i,0);
+			const V* cl = &A2(i-1,0);
+			const V* bl = &beti(i-1,0);
+			V* b = &beti(i,0);
+			V* g = &gam(i,0);
+			for(j=jl;j<ju;++j)
+			{
+				g[j] = cl[j]*bl[j];
+				b[j] = 1.0/(a1[j]-a0[j]*g[j]);
+			}
+		}
+
+		//	done
+		return;
+	}
+
+	//	tridag solve of interleaved lines with the factorization from tridagFactorLines, U and R may be the same
+	template <class V>
+	void	tridagSolveLines(
+		const kMatrixView<V>	A0,		//	n x m
+		const kMatrixView<V>	beti,
+		const kMatrixView<V>	gam,
+		const kMatrixView<V>	R,
+		kMatrixView<V>			U,
+		int						jl,
+		int						ju)
+	{
+		//	helps
+		int i, j;
+
+		//	dim
+		int n = A0.rows();
+		if(!n) return;
+
+		//	go
+		{
+			const V* r = &R(0,0);
+			const V* b = &beti(0,0);
+			V* u = &U(0,0);
+			for(j=jl;j<ju;++j) u[j] = r[j]*b[j];
+		}
+		for(i=1;i<n;++i)
+		{
+			const V* a0 = &A0(i,0);
+			const V* b	= &beti(i,0);
+			const V* r	= &R(i,0);
+			const V* ul = &U(i-1,0);
+			V* u = &U(i,0);
+			for(j=jl;j<ju;++j) u[j] = (r[j]-a0[j]*ul[j])*b[j];
+		}
+		for(i=n-2;i>=0;--i)
+		{
+			const V* g	= &gam(i+1,0);
+			const V* uu = &U(i+1,0);
+			V* u = &U(i,0);
+			for(j=jl;j<ju;++j) u[j] -= g[j]*uu[j];
+		}
+
+		//	done
+		return;
+	}
+
+	//	compact tridiagonal operators, n >= 5: C is 5 x 3 and holds the rows of
+	//	nodes 0, 1, any interior node, n-2 and n-1, all rows 2..n-3 are equal
+
+	//	storage row of node i
+	inline int	constRow(
+		int						i,
+		int						n)
+	{
+		return i<2 ? i : (i>=n-2 ? i-n+5 : 2);
+	}
+
+	//	band multiplication X = A B, the interior is one flat 3 point stencil over all slots
+	template <class V>
+	void	banmulMultiConst(
+		const kMatrixView<V>	C,		//	5 x 3
+		const kMatrixView<V>	B,		//	n x numV
+		kMatrixView<V>			X)		//	n x numV
+	{
+		//	dims
+		int n = B.rows();
+		int s = B.cols();
+
+		//	helps
+		int i, k;
+		V a0, a1, a2;
+
+		//	first rows
+		for(i=0;i<2;++i)
+		{
+			a0 = C(i,0);
+			a1 = C(i,1);
+			a2 = C(i,2);
+			const V* bl = i>0 ? &B(i-1,0) : nullptr;
+			const V* bi = &B(i,0);
+			const V* bu = &B(i+1,0);
+			V* xi = &X(i,0);
+			if(i>0)	for(k=0;k<s;++k) xi[k] = a0*bl[k] + a1*bi[k] + a2*bu[k];
+			else	for(k=0;k<s;++k) xi[k] = a1*bi[k] + a2*bu[k];
+		}
+
+		//	interior
+		{
+			a0 = C(2,0);
+			a1 = C(2,1);
+			a2 = C(2,2);
+			const V* b = &B(0,0);
+			V* x = &X(0,0);
+			int kl = 2*s, ku = (n-2)*s;
+			for(k=kl;k<ku;++k) x[k] = a0*b[k-s] + a1*b[k] + a2*b[k+s];
+		}
+
+		//	last rows
+		for(i=n-2;i<n;++i)
+		{
+			a0 = C(i-n+5,0);
+			a1 = C(i-n+5,1);
+			a2 = C(i-n+5,2);
+			const V* bl = &B(i-1,0);
+			const V* bi = &B(i,0);
+			const V* bu = i<n-1 ? &B(i+1,0) : nullptr;
+			V* xi = &X(i,0);
+			if(i<n-1)	for(k=0;k<s;++k) xi[k] = a0*bl[k] + a1*bi[k] + a2*bu[k];
+			else		for(k=0;k<s;++k) xi[k] = a0*bl[k] + a1*bi[k];
+		}
+
+		//	done
+		return;
+	}
+
+	//	tridag factor of a compact operator, returns the first node m from
+	//	which beti and gam are stationary up to node n-3 (n-2 if they are not)
+	template <class V>
+	int		tridagFactorConst(
+		const kMatrixView<V>	C,		//	5 x 3
+		int						n,
+		kVectorView<V>			beti,
+		kVectorView<V>			gam)
+	{
+		//	helps
+		V bet;
+		int j, jc, jl;
+
+		//	go
+		int m = n-2;
+		bet     = C(0,1);
+		beti(0) = 1.0/bet;
+		for(j=1;j<n;++j)
+		{
+			jc = constRow(j, n);
+			jl = constRow(j-1, n);
+			gam(j)  = C(jl,2)*beti(j-1);
+			bet     = C(jc,1)-C(jc,0)*gam(j);
+			beti(j) = 1.0/bet;
+
+			//	the recursion is the same map on nodes 2..n-3, a fixed point stays put
+			if(m==n-2 && j>=3 && j<=n-3 && beti(j)==beti(j-1)) m = j;
+		}
+
+		//	done
+		return m;
+	}
+
+	//	tridag solve with the factorization from tridagFactorConst, U and R may be the same
+	template <class V>
+	void	tridagSolveMultiConst(
+		const kMatrixView<V>	C,		//	5 x 3
+		const kVectorView<V>	beti,
+		const kVectorView<V>	gam,
+		int						m,
+		const kMatrixView<V>	R,		//	n x numV
+		kMatrixView<V>			U)		//	n x numV
+	{
+		//	helps
+		int j, h;
+		V a, b;
+
+		//	dims
+		int n = R.rows();
+		int numV = R.cols();
+
+		//	stationary coefficients
+		const V as = C(2,0);
+		const V bs = beti(m);
+		const V gs = gam(m);
+
+		//	single slot, contiguous
+		if(numV==1)
+		{
+			const V* r = &R(0,0);
+			V* u = &U(0,0);
+			u[0] = r[0]*beti(0);
+			for(j=1;j<m;++j)	u[j] = (r[j]-C(constRow(j, n),0)*u[j-1])*beti(j);
+			for(;j<=n-3;++j)	u[j] = (r[j]-as*u[j-1])*bs;
+			for(;j<n;++j)		u[j] = (r[j]-C(constRow(j, n),0)*u[j-1])*beti(j);
+			u[n-2] -= gam(n-1)*u[n-1];
+			for(j=n-3;j>=m-1;--j)	u[j] -= gs*u[j+1];
+			for(;j>=0;--j)			u[j] -= gam(j+1)*u[j+1];
+			return;
+		}
+
+		//	forward
+		{
+			const V* r0 = &R(0,0);
+			V* u0 = &U(0,0);
+			b = beti(0);
+			for(h=0;h<numV;++h) u0[h] = r0[h]*b;
+		}
+		for(j=1;j<n;++j)
+		{
+			//	stationary part
+			if(j==m)
+			{
+				for(;j<=n-3;++j)
+				{
+					const V* rj = &R(j,0);
+					const V* ul = &U(j-1,0);
+					V* uj = &U(j,0);
+					for(h=0;h<numV;++h) uj[h] = (rj[h]-as*ul[h])*bs;
+				}
+			}
+			const V* rj = &R(j,0);
+			const V* ul = &U(j-1,0);
+			V* uj = &U(j,0);
+			a = C(constRow(j, n),0);
+			b = beti(j);
+			for(h=0;h<numV;++h) uj[h] = (rj[h]-a*ul[h])*b;
+		}
+
+		//	backward, gam is stationary on nodes m..n-2
+		for(j=n-2;j>=0;--j)
+		{
+			const V* uu = &U(j+1,0);
+			V* uj = &U(j,0);
+			a = j+1>=m && j+1<=n-2 ? gs : gam(j+1);
+			for(h=0;h<numV;++h) uj[h] -= a*uu[h];
+		}
+
+		//	done
+		return;
+	}
+
+	//	solve: A U = R where A is left diag, U and R may be the same
+	template <class V>
+	void leftdagMulti(
+		const kMatrixView<V>	A,	//	nx2
+		const kMatrixView<V>	R,	//	n x numV
+		kMatrixView<V>			U)	//	n x numV
+	{
+		//	tjek
+		if(!A.rows()) return;
+
+		//	dims
+		int n = A.rows() - 1;
+		int numV = R.cols();
+
+		//	helps
+		int i, h;
+		V a, b;
+
+		//	loop
+		b = 1.0/A(0,1);
+		for(h=0;h<numV;++h) U(0,h) = R(0,h)*b;
+		for(i=1;i<=n;++i)
+		{
+			a = A(i,0);
+			b = 1.0/A(i,1);
+			const kVectorView<V> ri = R(i);
+			const kVectorView<V> ul = U(i-1);
+			kVectorView<V> ui = U(i);
+			for(h=0;h<numV;++h) ui(h) = (ri(h) - a*ul(h))*b;
+		}
+
+		//	done
+		return;
+	}
+
+	//	solve: A U = R where A is left diag, U and R may be the same
+	template <class V>
+	void leftdagMulti(
+		const kMatrix<V>&	A,	//	nx2
+		const kMatrix<V>&	R,	//	n x numV
+		kMatrix<V>&			U)	//	n x numV
+	{
+		//	resize
+		U.resize(A.rows(), R.cols());
+
+		leftdagMulti(A(), R(), U());
+
+		//	done
+		return;
+	}
+
+	//	solve: A U = R where A is right diag, U and R may be the same
+	template <class V>
+	void rightdagMulti(
+		const kMatrixView<V>	A,	//	nx2
+		const kMatrixView<V>	R,	//	n x numV
+		kMatrixView<V>			U)	//	n x numV
+	{
+		//	tjek
+		if (!A.rows()) return;
+
+		//	dims
+		int n = A.rows() - 1;
+		int numV = R.cols();
+
+		//	helps
+		int i, h;
+		V a, b;
+
+		//	loop
+		b = 1.0/A(n,0);
+		for(h=0;h<numV;++h) U(n,h) = R(n,h)*b;
+		for(i=n-1;i>=0;--i)
+		{
+			a = A(i,1);
+			b = 1.0/A(i,0);
+			const kVectorView<V> ri = R(i);
+			const kVectorView<V> uu = U(i+1);
+			kVectorView<V> ui = U(i);
+			for(h=0;h<numV;++h) ui(h) = (ri(h) - a*uu(h))*b;
+		}
+
+		//	done
+		return;
+	}
+
+	//	solve: A U = R where A is right diag, U and R may be the same
+	template <class V>
+	void rightdagMulti(
+		const kMatrix<V>&	A,	//	nx2
+		const kMatrix<V>&	R,	//	n x numV
+		kMatrix<V>&			U)	//	n x numV
+	{
+		//	resize
+		U.resize(A.rows(), R.cols());
+
+		rightdagMulti(A(), R(), U());
+
+		//	done
+		return;
+	}
 
 }
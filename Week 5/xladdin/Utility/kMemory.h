@@ -0,0 +1,98 @@
+#pragma once
+
+//	desc:	memory resources for kVector and kMatrix
+//
+//	the containers allocate through a polymorphic allocator bound, when the
+//	container is constructed, to the current resource of the calling thread.
+//	by default that is the heap, wrapped to count allocations. any other
+//	std::pmr::memory_resource (e.g. a kArena) can be made current for a scope
+//	with kMemory::scope. containers keep their resource for life, so they must
+//	not outlive it
+//
+//	the counters cover all heap allocations of kVector and kMatrix from all
+//	threads, incl arena refills, so zero heap traffic of a code section can be
+//	asserted as
+//
+//		long long n = kMemory::numAllocs();
+//		...
+//		assert(kMemory::numAllocs()==n);
+//
+
+//	includes
+#include <memory_resource>
+#include <atomic>
+#include <cstddef>
+
+//	class declaration
+class kMemory
+{
+public:
+
+	using resource = std::pmr::memory_resource;
+
+	//	heap allocations and bytes since start, all threads
+	static long long	numAllocs()		{ return heapImpl().myNumAllocs.load(std::memory_order_relaxed); }
+	static long long	numBytes()		{ return heapImpl().myNumBytes.load(std::memory_order_relaxed); }
+
+	//	counting heap
+	static resource*	heap()			{ return &heapImpl(); }
+
+	//	current resource of this thread
+	static resource*	current()		{ resource* r = currentImpl(); return r ? r : heap(); }
+
+	//	make a resource current for the lifetime of the scope
+	class scope
+	{
+	public:
+		explicit scope(resource* r) : myPrev(currentImpl()) { currentImpl() = r; }
+		~scope() { currentImpl() = myPrev; }
+
+		scope(const scope&) = delete;
+		scope& operator=(const scope&) = delete;
+
+	private:
+		resource*	myPrev;
+	};
+
+private:
+
+	//	heap with counters
+	class countingHeap : public resource
+	{
+	public:
+		std::atomic<long long>	myNumAllocs{0};
+		std::atomic<long long>	myNumBytes{0};
+
+	private:
+		void*	do_allocate(size_t bytes, size_t align) override
+		{
+			myNumAllocs.fetch_add(1, std::memory_order_relaxed);
+			myNumBytes.fetch_add((long long)bytes, std::memory_order_relaxed);
+			return std::pmr::new_delete_resource()->allocate(bytes, align);
+		}
+		void	do_deallocate(void* p, size_t bytes, size_t align) override
+		{
+			std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+		}
+		bool	do_is_equal(const resource& rhs) const noexcept override
+		{
+			return this==&rhs;
+		}
+	};
+
+	static countingHeap&	heapImpl()		{ static countingHeap h; return h; }
+	static resource*&		currentImpl()	{ thread_local resource* r = nullptr; return r; }
+};
+
+//	arena: monotonic buffer refilled from the counting heap. deallocation is a
+//	no-op, release() frees everything at once
+class kArena : public std::pmr::monotonic_buffer_resource
+{
+public:
+	explicit kArena(size_t initialSize = 1 << 16)
+		: std::pmr::monotonic_buffer_resource(initialSize, kMemory::heap()) {}
+
+	//	from a caller owned buffer, refilled from the counting heap once exhausted
+	kArena(void* buffer, size_t size)
+		: std::pmr::monotonic_buffer_resource(buffer, size, kMemory::heap()) {}
+};
@@ -0,0 +1,291 @@
+#pragma once
+
+//	desc:	partitioned tridiagonal solver on a thread pool
+//
+//	the n rows are cut into P partitions of consecutive rows. every partition
+//	eliminates its interior independently, first downwards expressing its
+//	rows in the last unknown of the previous partition, then upwards in the
+//	last unknown of its own, so only the P last unknowns x(p) remain coupled
+//	through a P x P tridiagonal system. that one is solved serially and the
+//	partitions then substitute back in parallel. factorization and solve are
+//	split like tridagFactor/tridagSolve, so a cached operator is eliminated
+//	once and solved for many right hand sides
+//
+//	the partitioned solve costs about twice the thomas algorithm, so the
+//	threaded path is taken for n >= minSize on pools of at least 3 threads,
+//	otherwise the serial tridagFactor/tridagSolve is used. run() on a
+//	pool is not reentrant: do not solve on a pool from tasks of the same pool
+//
+//	results agree with tridag to round-off for diagonally dominant systems
+//
+
+//	includes
+#include "kMatrixAlgebra.h"
+#include "kThreadPool.h"
+
+//	class declaration
+template <class V>
+class kParallelTridag
+{
+public:
+
+	//	default threshold
+	static constexpr int	defaultMinSize = 1 << 16;
+
+	//	c'tor, null pool uses the shared pool
+	explicit kParallelTridag(
+		kThreadPool*			pool	= nullptr,
+		int						minSize	= defaultMinSize)
+		: myPool(pool), myMinSize(minSize) {}
+
+	//	settings
+	void	setPool(kThreadPool* pool)		{ myPool = pool; }
+	void	setMinSize(int minSize)			{ myMinSize = minSize; }
+	int		minSize()				const	{ return myMinSize; }
+
+	//	threaded path for a system of n rows
+	bool	threaded(int n)			const	{ return n>=max(4, myMinSize) && pool().numThreads()>=3; }
+
+	//	factor A
+	void	factor(
+		const kMatrixView<V>	A);		//	n x 3
+
+	//	solve A U = R, U and R may be the same
+	void	solve(
+		const kMatrixView<V>	R,		//	n x numV
+		kMatrixView<V>			U);		//	n x numV
+
+	//	solve A u = r, u and r may be the same
+	void	solve(
+		const kVectorView<V>	r,
+		kVectorView<V>			u)
+	{
+		solve(kMatrixView<V>(&r(0), r.size(), 1), kMatrixView<V>(&u(0), u.size(), 1));
+	}
+
+private:
+
+	//	pool
+	kThreadPool&	pool() const { return myPool ? *myPool : kThreadPool::global(); }
+
+	//	first row of partition p
+	int		lo(int p) const { return (int)((long long)myN*p/myP); }
+
+	//	settings
+	kThreadPool*	myPool;
+	int				myMinSize;
+
+	//	operator, dims, partitions
+	kMatrixView<V>	myA;
+	int				myN{0};
+	int				myP{0};
+	bool			myThreaded{false};
+
+	//	elimination: n x 4 with columns 1/pivot, forward super diag, and the
+	//	upward coefficients of the previous and own last unknown
+	kMatrix<V>		myF;
+
+	//	reduced system and its factorization
+	kMatrix<V>		myRa;
+	kVector<V>		myRbeti, myRgam;
+
+	//	serial factorization
+	kVector<V>		myBeti, myGam;
+
+	//	reduced right hand sides and solutions, P x numV
+	kMatrix<V>		myX;
+};
+
+//	factor
+template <class V>
+void
+kParallelTridag<V>::factor(
+	const kMatrixView<V>	A)
+{
+	//	dims
+	myA	 = A;
+	myN	 = A.rows();
+	myThreaded = threaded(myN);
+
+	//	serial
+	if(!myThreaded)
+	{
+		myBeti.resize(myN);
+		myGam.resize(myN);
+		kMatrixAlgebra::tridagFactor(A, myBeti(), myGam());
+		return;
+	}
+
+	//	partitions of at least 2 rows
+	myP = min(4*pool().numThreads(), myN/2);
+	myF.resize(myN, 4);
+	myRa.resize(myP, 3);
+
+	//	eliminate partitions
+	pool().parallelFor(myP, [&](int p, int)
+	{
+		int il = lo(p), iu = lo(p+1)-1;
+		int i;
+		V	piv, a, c;
+
+		//	downwards: u(i) = D(i) - Af(i) x(p-1) - Cf(i) u(i+1)
+		a	= p>0 ? A(il,0) : V(0.0);
+		c	= il<myN-1 ? A(il,2) : V(0.0);
+		piv = 1.0/A(il,1);
+		myF(il,0) = piv;
+		myF(il,1) = c*piv;
+		myF(il,2) = a*piv;
+		for(i=il+1;i<=iu;++i)
+		{
+			c	= i<myN-1 ? A(i,2) : V(0.0);
+			piv	= 1.0/(A(i,1)-A(i,0)*myF(i-1,1));
+			myF(i,0) =  piv;
+			myF(i,1) =  c*piv;
+			myF(i,2) = -piv*A(i,0)*myF(i-1,2);
+		}
+
+		//	upwards: u(i) = D'(i) - Ab(i) x(p-1) - Cb(i) x(p), i < iu
+		myF(iu-1,3) = myF(iu-1,1);
+		for(i=iu-2;i>=il;--i)
+		{
+			myF(i,2) -=  myF(i,1)*myF(i+1,2);
+			myF(i,3)  = -myF(i,1)*myF(i+1,3);
+		}
+	});
+
+	//	reduced system in the last unknowns x(p)
+	for(int p=0;p<myP;++p)
+	{
+		int iu = lo(p+1)-1;
+		V	cf = myF(iu,1);
+		myRa(p,0) = myF(iu,2);
+		myRa(p,1) = p<myP-1 ? 1.0 - cf*myF(iu+1,2) : V(1.0);
+		myRa(p,2) = p<myP-1 ?	  - cf*myF(iu+1,3) : V(0.0);
+	}
+	kMatrixAlgebra::tridagFactor(myRa, myRbeti, myRgam);
+
+	//	done
+	return;
+}
+
+//	solve
+template <class V>
+void
+kParallelTridag<V>::solve(
+	const kMatrixView<V>	R,
+	kMatrixView<V>			U)
+{
+	//	serial
+	if(!myThreaded)
+	{
+		kMatrixAlgebra::tridagSolveMulti(myA, myBeti(), myGam(), R, U);
+		return;
+	}
+
+	//	dims
+	int numV = R.cols();
+	myX.resize(myP, numV);
+
+	//	downwards and upwards within the partitions, D' into U
+	pool().parallelFor(myP, [&](int p, int)
+	{
+		int il = lo(p), iu = lo(p+1)-1;
+		int i, h;
+		V	a, b;
+
+		{
+			const V* r = &R(il,0);
+			V* u = &U(il,0);
+			b = myF(il,0);
+			for(h=0;h<numV;++h) u[h] = r[h]*b;
+		}
+		for(i=il+1;i<=iu;++i)
+		{
+			const V* r	= &R(i,0);
+			const V* ul	= &U(i-1,0);
+			V* u = &U(i,0);
+			a = myA(i,0);
+			b = myF(i,0);
+			for(h=0;h<numV;++h) u[h] = (r[h]-a*ul[h])*b;
+		}
+		for(i=iu-2;i>=il;--i)
+		{
+			const V* uu	= &U(i+1,0);
+			V* u = &U(i,0);
+			a = myF(i,1);
+			for(h=0;h<numV;++h) u[h] -= a*uu[h];
+		}
+	});
+
+	//	reduced right hand sides: D(iu) - Cf(iu) D'(first row of p+1)
+	{
+		int p, h;
+		for(p=0;p<myP;++p)
+		{
+			int iu = lo(p+1)-1;
+			const V* d = &U(iu,0);
+			V* x = &myX(p,0);
+			if(p<myP-1)
+			{
+				const V* dn = &U(iu+1,0);
+				V cf = myF(iu,1);
+				for(h=0;h<numV;++h) x[h] = d[h] - cf*dn[h];
+			}
+			else
+			{
+				for(h=0;h<numV;++h) x[h] = d[h];
+			}
+		}
+		kMatrixAlgebra::tridagSolveMulti(myRa(), myRbeti(), myRgam(), myX(), myX());
+	}
+
+	//	substitute
+	pool().parallelFor(myP, [&](int p, int)
+	{
+		int il = lo(p), iu = lo(p+1)-1;
+		int i, h;
+		V	a, c;
+
+		const V* xl = p>0 ? &myX(p-1,0) : nullptr;
+		const V* xp = &myX(p,0);
+		for(i=il;i<iu;++i)
+		{
+			V* u = &U(i,0);
+			a = myF(i,2);
+			c = myF(i,3);
+			if(xl)	for(h=0;h<numV;++h) u[h] -= a*xl[h] + c*xp[h];
+			else	for(h=0;h<numV;++h) u[h] -= c*xp[h];
+		}
+		V* u = &U(iu,0);
+		for(h=0;h<numV;++h) u[h] = xp[h];
+	});
+
+	//	done
+	return;
+}
+
+//	one shot
+namespace kMatrixAlgebra
+{
+	//	tridag on the threads of pool (null for the shared pool), serial below minSize
+	template <class V>
+	void	tridagParallel(
+		const kMatrix<V>&	A,		//	n x 3
+		const kVector<V>&	r,
+		kVector<V>&			u,
+		kThreadPool*		pool	= nullptr,
+		int					minSize	= kParallelTridag<V>::defaultMinSize)
+	{
+		//	dim
+		int n = A.rows();
+		if(u.size()<n) u.resize(n);
+		if(!n) return;
+
+		kParallelTridag<V> solver(pool, minSize);
+		solver.factor(A());
+		solver.solve(r(), u());
+
+		//	done
+		return;
+	}
+}
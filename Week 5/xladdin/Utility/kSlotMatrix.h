@@ -0,0 +1,198 @@
+#pragma once
+
+//	desc:	contiguous storage of numV result slots on a grid of numX nodes
+//
+//		node major:	row i holds all slots at node i, slot index inner (default, used by the batched fd kernels)
+//		slot major:	row k holds slot k at all nodes, node index inner
+//
+//	rows can be padded to a multiple of align elements and the first row
+//	aligned on an align*sizeof(V) byte boundary, padded entries are carried
+//	along by the kernels but are otherwise ignored
+
+//	includes
+#include "kMatrix.h"
+#include <cstdint>
+
+//	class declaration
+template <class V=double>
+class kSlotMatrix
+{
+public:
+
+	//	layout
+	enum Layout
+	{
+		nodeMajor,
+		slotMajor
+	};
+
+	//	c'tors
+	kSlotMatrix() = default;
+	kSlotMatrix(int numV, int numX, Layout layout = nodeMajor, int align = 1)
+	{
+		resize(numV, numX, layout, align);
+	}
+
+	//	copy, the aligned offset may differ so copy element wise
+	kSlotMatrix(const kSlotMatrix& rhs)
+	{
+		*this = rhs;
+	}
+	kSlotMatrix& operator=(const kSlotMatrix& rhs)
+	{
+		if(this==&rhs) return *this;
+		resize(rhs.myNumV, rhs.myNumX, rhs.myLayout, rhs.myAlign);
+		rhs.copyTo(*this);
+		return *this;
+	}
+
+	//	move, the heap block and hence the aligned pointer moves along
+	kSlotMatrix(kSlotMatrix&& rhs) noexcept = default;
+	kSlotMatrix& operator=(kSlotMatrix&& rhs)
+	{
+		if(this==&rhs) return *this;
+
+		//	storage from another memory resource is copied, not stolen
+		if(myData.data().get_allocator()!=rhs.myData.data().get_allocator())
+		{
+			return *this = static_cast<const kSlotMatrix&>(rhs);
+		}
+		myData	 = std::move(rhs.myData);
+		myPtr	 = rhs.myPtr;
+		myNumV	 = rhs.myNumV;
+		myNumX	 = rhs.myNumX;
+		myStride = rhs.myStride;
+		myAlign	 = rhs.myAlign;
+		myStrK	 = rhs.myStrK;
+		myStrI	 = rhs.myStrI;
+		myLayout = rhs.myLayout;
+		return *this;
+	}
+
+	//	resize, content is not preserved when dims change
+	void	resize(int numV, int numX, Layout layout = nodeMajor, int align = 1)
+	{
+		align = max(1, align);
+		if(numV==myNumV && numX==myNumX && layout==myLayout && align==myAlign && !myData.empty()) return;
+
+		myNumV	 = max(0, numV);
+		myNumX	 = max(0, numX);
+		myLayout = layout;
+		myAlign	 = align;
+
+		//	padded rows
+		int rows = myLayout==nodeMajor ? myNumX : myNumV;
+		int cols = myLayout==nodeMajor ? myNumV : myNumX;
+		myStride = align * ((cols + align - 1) / align);
+
+		//	one spare row to absorb the alignment offset
+		myData.resize(rows + (align>1 ? 1 : 0), myStride, V(0.0));
+		setView();
+	}
+
+	//	dims
+	int		numV()		const { return myNumV; }
+	int		numX()		const { return myNumX; }
+	int		stride()	const { return myStride; }
+	Layout	layout()	const { return myLayout; }
+	bool	empty()		const { return myNumV==0 || myNumX==0; }
+
+	//	element access: slot k, node i
+	const V& operator()(int k, int i) const
+	{
+#ifdef _DEBUG
+		if(k<0 || k>=myNumV) throw std::runtime_error("kSlotMatrix slot subscript out of range");
+		if(i<0 || i>=myNumX) throw std::runtime_error("kSlotMatrix node subscript out of range");
+#endif
+		return myPtr[k*myStrK + i*myStrI];
+	}
+	V& operator()(int k, int i)
+	{
+#ifdef _DEBUG
+		if(k<0 || k>=myNumV) throw std::runtime_error("kSlotMatrix slot subscript out of range");
+		if(i<0 || i>=myNumX) throw std::runtime_error("kSlotMatrix node subscript out of range");
+#endif
+		return myPtr[k*myStrK + i*myStrI];
+	}
+
+	//	padded matrix view: numX x stride (node major) or numV x stride (slot major)
+	const kMatrixView<V>	operator()() const { return kMatrixView<V>(myPtr, myLayout==nodeMajor ? myNumX : myNumV, myStride); }
+	kMatrixView<V>			operator()()       { return kMatrixView<V>(myPtr, myLayout==nodeMajor ? myNumX : myNumV, myStride); }
+
+	//	contiguous slot view, slot major only
+	const kVectorView<V>	slot(int k) const
+	{
+		if(myLayout!=slotMajor) throw std::runtime_error("kSlotMatrix::slot(): slots are not contiguous in node major layout");
+		return kVectorView<V>(myPtr + k*myStride, myNumX);
+	}
+	kVectorView<V>			slot(int k)
+	{
+		if(myLayout!=slotMajor) throw std::runtime_error("kSlotMatrix::slot(): slots are not contiguous in node major layout");
+		return kVectorView<V>(myPtr + k*myStride, myNumX);
+	}
+
+	//	copy slot in and out
+	void	getSlot(int k, kVector<V>& out) const
+	{
+		out.resize(myNumX);
+		for(int i=0;i<myNumX;++i) out(i) = (*this)(k,i);
+	}
+	void	setSlot(int k, const kVector<V>& in)
+	{
+		int n = min(myNumX, in.size());
+		for(int i=0;i<n;++i) (*this)(k,i) = in(i);
+	}
+
+	//	compatibility with vector of vectors storage
+	void	getSlots(kVector<kVector<V>>& out) const
+	{
+		out.resize(myNumV);
+		for(int k=0;k<myNumV;++k) getSlot(k, out(k));
+	}
+	void	setSlots(const kVector<kVector<V>>& in)
+	{
+		int numX = in.empty() ? 0 : in(0).size();
+		resize(in.size(), numX, myLayout, myAlign);
+		for(int k=0;k<myNumV;++k) setSlot(k, in(k));
+	}
+
+	//	copy to other matrix of same dims, any layout
+	void	copyTo(kSlotMatrix& out) const
+	{
+		int k, i;
+		for(k=0;k<myNumV;++k)
+		{
+			for(i=0;i<myNumX;++i) out(k,i) = (*this)(k,i);
+		}
+	}
+
+private:
+
+	//	set pointer and strides
+	void	setView()
+	{
+		V* p = myData.empty() ? nullptr : &myData[0];
+		if(p && myAlign>1)
+		{
+			size_t bytes = myAlign*sizeof(V);
+			size_t off	 = (bytes - reinterpret_cast<std::uintptr_t>(p) % bytes) % bytes;
+			p += off / sizeof(V);
+		}
+		myPtr  = p;
+		myStrK = myLayout==nodeMajor ? 1 : myStride;
+		myStrI = myLayout==nodeMajor ? myStride : 1;
+	}
+
+	//	storage
+	kMatrix<V>	myData;
+	V*			myPtr{nullptr};
+
+	//	dims
+	int			myNumV{0};
+	int			myNumX{0};
+	int			myStride{0};
+	int			myAlign{1};
+	int			myStrK{1};
+	int			myStrI{0};
+	Layout		myLayout{nodeMajor};
+};
@@ -0,0 +1,201 @@
+#include "kThreadPool.h"
+
+//	c'tor
+kThreadPool::kThreadPool(
+	int	numThreads)
+{
+	//	threads
+	if(numThreads<=0) numThreads = (int)std::thread::hardware_concurrency();
+	myNumThreads = max(1, numThreads);
+
+	//	queues
+	myQueues.resize(myNumThreads);
+	myQueueMutex.reset(new std::mutex[myNumThreads]);
+
+	//	spawn workers, the caller is thread 0
+	myThreads.reserve(myNumThreads-1);
+	for(int t=1;t<myNumThreads;++t)
+	{
+		myThreads.push_back(std::thread(&kThreadPool::worker, this, t));
+	}
+}
+
+//	d'tor
+kThreadPool::~kThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lk(myMutex);
+		myStop = true;
+	}
+	myStart.notify_all();
+	for(auto& th : myThreads) th.join();
+}
+
+//	shared pool
+kThreadPool&
+kThreadPool::global()
+{
+	static kThreadPool pool;
+	return pool;
+}
+
+//	run tasks
+void
+kThreadPool::run(
+	const kVector<kVector<int>>&	queues,
+	const Task&						f)
+{
+	//	helps
+	int t, i;
+
+	//	concurrent callers queue up
+	std::lock_guard<std::mutex> job(myRunMutex);
+
+	//	fill queues, surplus queues go to the last threads
+	for(t=0;t<myNumThreads;++t) myQueues(t).clear();
+	for(t=0;t<queues.size();++t)
+	{
+		std::deque<int>& q = myQueues(t % myNumThreads);
+		for(i=0;i<queues(t).size();++i) q.push_back(queues(t)(i));
+	}
+
+	//	single thread
+	if(myNumThreads==1)
+	{
+		myTask = &f;
+		work(0);
+		myTask = nullptr;
+	}
+	else
+	{
+		//	start workers
+		{
+			std::lock_guard<std::mutex> lk(myMutex);
+			myTask	 = &f;
+			myActive = myNumThreads - 1;
+			myError	 = nullptr;
+			++myGeneration;
+		}
+		myStart.notify_all();
+
+		//	take part
+		work(0);
+
+		//	wait for workers
+		std::unique_lock<std::mutex> lk(myMutex);
+		myDone.wait(lk, [this] { return myActive==0; });
+		myTask = nullptr;
+	}
+
+	//	propagate first error
+	if(myError)
+	{
+		std::exception_ptr e = myError;
+		myError = nullptr;
+		std::rethrow_exception(e);
+	}
+
+	//	done
+	return;
+}
+
+//	parallel for
+void
+kThreadPool::parallelFor(
+	int				numTasks,
+	const Task&		f)
+{
+	//	chunks of contiguous tasks, a few per thread to leave room for stealing
+	int numChunks = min(numTasks, 4*myNumThreads);
+	kVector<kVector<int>> queues(myNumThreads);
+	for(int c=0;c<numChunks;++c)
+	{
+		int il = (int)((long long)numTasks*c/numChunks);
+		int iu = (int)((long long)numTasks*(c+1)/numChunks);
+		for(int i=il;i<iu;++i) queues(c % myNumThreads).push_back(i);
+	}
+
+	run(queues, f);
+
+	//	done
+	return;
+}
+
+//	worker loop
+void
+kThreadPool::worker(
+	int	t)
+{
+	int generation = 0;
+	while(true)
+	{
+		{
+			std::unique_lock<std::mutex> lk(myMutex);
+			myStart.wait(lk, [&] { return myStop || myGeneration!=generation; });
+			if(myStop) return;
+			generation = myGeneration;
+		}
+
+		work(t);
+
+		{
+			std::lock_guard<std::mutex> lk(myMutex);
+			if(--myActive==0) myDone.notify_all();
+		}
+	}
+}
+
+//	drain own queue and steal
+void
+kThreadPool::work(
+	int	t)
+{
+	int task;
+	while(next(t, task))
+	{
+		try
+		{
+			(*myTask)(task, t);
+		}
+		catch(...)
+		{
+			std::lock_guard<std::mutex> lk(myMutex);
+			if(!myError) myError = std::current_exception();
+		}
+	}
+
+	//	done
+	return;
+}
+
+//	next task: own queue from the front, others from the back
+bool
+kThreadPool::next(
+	int		t,
+	int&	task)
+{
+	{
+		std::lock_guard<std::mutex> lk(myQueueMutex[t]);
+		if(!myQueues(t).empty())
+		{
+			task = myQueues(t).front();
+			myQueues(t).pop_front();
+			return true;
+		}
+	}
+
+	for(int k=1;k<myNumThreads;++k)
+	{
+		int v = (t + k) % myNumThreads;
+		std::lock_guard<std::mutex> lk(myQueueMutex[v]);
+		if(!myQueues(v).empty())
+		{
+			task = myQueues(v).back();
+			myQueues(v).pop_back();
+			return true;
+		}
+	}
+
+	//	nothing left
+	return false;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+//	desc:	work stealing thread pool
+//
+//	every thread owns a deque of task indices, pops its own tasks from the
+//	front and, once empty, steals from the back of the other deques. the
+//	calling thread takes part as thread 0, so a pool of n threads spawns n-1
+//	workers. run() is not reentrant: tasks must not call run() on the same pool.
+//	concurrent callers from other threads are serialized, one job at a time
+
+//	includes
+#include "kVector.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <exception>
+#include <memory>
+
+//	class declaration
+class kThreadPool
+{
+public:
+
+	//	task: f(task, thread)
+	using Task = std::function<void(int, int)>;
+
+	//	c'tor, numThreads <= 0 uses the hardware concurrency
+	explicit kThreadPool(int numThreads = 0);
+	~kThreadPool();
+
+	kThreadPool(const kThreadPool&) = delete;
+	kThreadPool& operator=(const kThreadPool&) = delete;
+
+	//	number of threads incl the caller
+	int		numThreads() const { return myNumThreads; }
+
+	//	run tasks, queues(t) holds the tasks initially assigned to thread t
+	void	run(
+		const kVector<kVector<int>>&	queues,
+		const Task&						f);
+
+	//	run numTasks tasks, dealt round robin in contiguous chunks
+	void	parallelFor(
+		int								numTasks,
+		const Task&						f);
+
+	//	shared pool with hardware concurrency
+	static kThreadPool&	global();
+
+private:
+
+	//	worker loop
+	void	worker(int t);
+
+	//	drain own queue and steal
+	void	work(int t);
+
+	//	next task for thread t
+	bool	next(int t, int& task);
+
+	//	threads
+	int							myNumThreads;
+	vector<std::thread>			myThreads;
+
+	//	per thread task deques
+	kVector<std::deque<int>>	myQueues;
+	std::unique_ptr<std::mutex[]>	myQueueMutex;
+
+	//	one job at a time
+	std::mutex					myRunMutex;
+
+	//	job state
+	std::mutex					myMutex;
+	std::condition_variable		myStart, myDone;
+	const Task*					myTask{nullptr};
+	int							myGeneration{0};
+	int							myActive{0};
+	bool						myStop{false};
+	std::exception_ptr			myError;
+};
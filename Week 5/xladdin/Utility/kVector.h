@@ -5,6 +5,7 @@
 #include<span>
 #include <algorithm>
 #include <stdexcept>
+#include "kMemory.h"
 
 using std::vector;
 using std::set;
@@ -21,16 +22,16 @@ template<typename T=double>
 class kVector 
 {
 public:
-	using Container = vector<T>;
+	using Container = std::pmr::vector<T>;
 
 	//	declarations
 	using value_type = T;
 
-	//	trivi c'tors
-	kVector()=default;
-	explicit kVector(size_t size) : myData(size){}
-	kVector(size_t size, T t0) : myData(size,t0){}
-	kVector(const kVector& rhs)=default;
+	//	trivi c'tors, storage comes from the current kMemory resource
+	kVector() : myData(kMemory::current()){}
+	explicit kVector(size_t size) : myData(size,kMemory::current()){}
+	kVector(size_t size, T t0) : myData(size,t0,kMemory::current()){}
+	kVector(const kVector& rhs) : myData(rhs.myData,kMemory::current()){}
 	kVector(kVector&& rhs)noexcept=default;
 	~kVector()noexcept=default;
 
@@ -123,8 +124,8 @@ public:
 	//	c'tors will make a view on the rhs (i.e. updating values will update the rhs)
 	kVectorView(kVector<T>& rhs): myView(rhs.data()){}
 	kVectorView(const kVector<T>& rhs) : myView(const_cast<kVector<T>&>(rhs).data()){}
-	kVectorView(vector<T>& rhs) : myView(rhs){}
-	kVectorView(const vector<T>& rhs) : myView(const_cast<vector<T>&>(rhs)){}
+	template<class A> kVectorView(vector<T,A>& rhs) : myView(rhs){}
+	template<class A> kVectorView(const vector<T,A>& rhs) : myView(const_cast<vector<T,A>&>(rhs)){}
 	kVectorView(T& rhs) : myView(&rhs,1){}
 	kVectorView(const T& rhs) : myView(&const_cast<T&>(rhs),1){}
 	explicit kVectorView(view& rhs) : myView(rhs){}